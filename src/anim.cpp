@@ -0,0 +1,41 @@
+#include "anim.h"
+
+#include <utility>
+
+namespace tetriskl {
+    Animator::Animator() : animations() {}
+
+    void Animator::start(sf::Time duration, update_fn update, finish_fn finish) {
+        animations.push_back(Animation{duration, sf::Time::Zero, std::move(update), std::move(finish)});
+        animations.back().update(sf::Time::Zero);
+    }
+
+    void Animator::advance(sf::Time dt) {
+        // finish functions may start new animations, so finished ones are collected first
+        std::vector<Animation> finished;
+        for (auto it = animations.begin(); it != animations.end();) {
+            it->elapsed += dt;
+            if (it->elapsed >= it->duration) {
+                finished.push_back(std::move(*it));
+                it = animations.erase(it);
+            } else {
+                it->update(it->elapsed);
+                ++it;
+            }
+        }
+
+        for (Animation &animation : finished)
+            animation.finish();
+    }
+
+    void Animator::finish_all() {
+        std::vector<Animation> finished;
+        std::swap(finished, animations);
+        for (Animation &animation : finished)
+            animation.finish();
+    }
+
+    bool Animator::is_running() const {
+        return !animations.empty();
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef ANIM_H_
+#define ANIM_H_
+
+#include <functional>
+#include <vector>
+#include <SFML/System.hpp>
+
+namespace tetriskl {
+    // Klase Animator glabā notiekošās animācijas un pavirza tās uz priekšu, kad galvenais cikls izsauc advance.
+    // Animācijas nekad neaptur spēli: tās tikai izsauc savas update un finish funkcijas.
+    class Animator {
+    public:
+        using update_fn = std::function<void(sf::Time elapsed)>;
+        using finish_fn = std::function<void()>;
+    private:
+        struct Animation {
+            sf::Time duration;
+            sf::Time elapsed;
+            update_fn update;
+            finish_fn finish;
+        };
+
+        std::vector<Animation> animations;
+    public:
+        Animator();
+
+        // metode start(duration, update, finish) sāk animāciju, kas ilgst duration. Funkcija update tiek
+        // izsaukta uzreiz un pēc katra advance ar pagājušo laiku, bet finish — vienreiz, kad animācija beidzas.
+        void start(sf::Time duration, update_fn update, finish_fn finish);
+        // metode advance(dt) pavirza visas animācijas par laiku dt un pabeidz tās, kuru laiks ir beidzies
+        void advance(sf::Time dt);
+        // metode finish_all() uzreiz pabeidz visas animācijas
+        void finish_all();
+        bool is_running() const;
+    };
+}
+
+#endif // ANIM_H_
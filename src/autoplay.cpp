@@ -0,0 +1,26 @@
+#include "autoplay.h"
+
+namespace tetriskl {
+    GameResult play_game(std::uint32_t seed, Bot &bot, unsigned int max_pieces, const Ruleset &rules) {
+        Simulation sim(seed, rules);
+        unsigned int pieces = 0;
+        while (!sim.is_game_over() && pieces < max_pieces) {
+            const std::vector<Action> &path = bot.choose(sim.get_board(), sim.get_falling_piece(),
+                                                         sim.get_next_piece(), sim.get_falling_piece_pos());
+            // with nowhere to go the piece is left to gravity until it locks
+            if (sim.step(path).piece_locked) pieces++;
+        }
+        return GameResult{seed, sim.get_score(), sim.get_lines(), pieces, sim.is_game_over()};
+    }
+
+    std::vector<GameResult> play_games(WorkStealingPool &pool, const std::vector<std::uint32_t> &seeds,
+                                       const BotWeights &weights, unsigned int max_pieces, const Ruleset &rules) {
+        std::vector<GameResult> results(seeds.size());
+        // every thread reuses one bot and its search tables for all of its games
+        std::vector<Bot> bots(pool.size(), Bot(weights));
+        pool.run(seeds.size(), [&] (std::size_t game, std::size_t worker) {
+            results[game] = play_game(seeds[game], bots[worker], max_pieces, rules);
+        });
+        return results;
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef AUTOPLAY_H_
+#define AUTOPLAY_H_
+#include "bot.h"
+#include "sim.h"
+#include "workpool.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace tetriskl {
+    // struktūra GameResult apraksta vienas robota nospēlētas spēles iznākumu
+    struct GameResult {
+        std::uint32_t seed;
+        unsigned int score;
+        unsigned int lines;
+        unsigned int pieces;
+        // false, ja spēle tika apturēta, sasniedzot gabalu ierobežojumu
+        bool game_over;
+    };
+
+    // funkcija play_game(seed, bot, max_pieces, rules) nospēlē vienu spēli ar sēklu seed, kurā gabalus novieto bot,
+    // līdz spēle beidzas vai ir novietoti max_pieces gabali
+    GameResult play_game(std::uint32_t seed, Bot &bot, unsigned int max_pieces, const Ruleset &rules = default_ruleset);
+
+    // funkcija play_games(pool, seeds, weights, max_pieces, rules) nospēlē pa vienai spēlei katrai sēklai no seeds,
+    // sadalot tās starp pūla pool pavedieniem. Rezultāti ir tādā pašā secībā kā sēklas.
+    std::vector<GameResult> play_games(WorkStealingPool &pool, const std::vector<std::uint32_t> &seeds,
+                                       const BotWeights &weights, unsigned int max_pieces,
+                                       const Ruleset &rules = default_ruleset);
+}
+
+#endif // AUTOPLAY_H_
@@ -0,0 +1,318 @@
+#include "batchsim.h"
+#include "bitops.h"
+#include "lanes.h"
+
+#include <algorithm>
+
+namespace tetriskl {
+    constexpr std::uint8_t full_bag_mask = (1 << NUM_TETROMINOES) - 1;
+
+    // returns -1 in the lanes where any of the TETROMINO_CELLS rows of the pieces at row y overlaps the board;
+    // both point at the first row of one block of games
+    static lane_vector collisions(const std::int32_t *board, const std::int32_t *rows, std::size_t y) {
+        lane_vector hit = lanes_splat(0);
+        for (std::size_t dy = 0; dy < TETROMINO_CELLS; dy++)
+            hit = hit | (lanes_load(&board[(y + dy) * LANE_WIDTH]) & lanes_load(&rows[dy * LANE_WIDTH]));
+        return hit != lanes_splat(0);
+    }
+
+    // Every array with several rows per game keeps one block of LANE_WIDTH games together: row y of all of them
+    // side by side, then row y + 1. A step only touches one block at a time, so it stays in a few cache lines,
+    // whereas one long row of all games per y would put every row of a block in the same cache set.
+    static std::size_t tile_index(std::size_t game, std::size_t y, std::size_t rows_per_game) {
+        return (game / LANE_WIDTH * rows_per_game + y) * LANE_WIDTH + game % LANE_WIDTH;
+    }
+
+    // the table lookup Tetromino::state() does, without constructing a Tetromino out of line for it
+    static const TetrominoState& piece_state(Cell kind, Rotation rotation = Rotation::NONE) {
+        return Tetromino::state_table.states[(int)kind][(int)rotation];
+    }
+
+    std::size_t BatchSimulator::lane_width() {
+        return LANE_WIDTH;
+    }
+
+    BatchSimulator::BatchSimulator(std::size_t num_games, std::uint64_t seed)
+        : num_games(num_games),
+          stride((num_games + LANE_WIDTH - 1) / LANE_WIDTH * LANE_WIDTH),
+          occupancy(stored_rows * stride, 0),
+          column_tops(Board::columns * stride, Board::rows),
+          piece_rows(TETROMINO_CELLS * stride, 0),
+          spawn_rows(TETROMINO_CELLS * stride, 0),
+          piece_heights(stride, 0),
+          spawn_heights(stride, 0),
+          cleared(stride, 0),
+          landing_rows(stride, 0),
+          pieces(stride, Cell::N),
+          rngs(stride),
+          bags(stride, 0),
+          game_over(stride, 1),
+          lines(stride, 0),
+          scores(stride, 0),
+          placed(stride, 0) {
+        Pcg32 root(seed);
+        for (std::size_t game = 0; game < num_games; game++) {
+            rngs[game] = root.split();
+            pieces[game] = deal(game);
+            game_over[game] = 0;
+        }
+    }
+
+    std::uint32_t BatchSimulator::random_below(std::size_t game, std::uint32_t bound) {
+        return rngs[game].bounded(bound);
+    }
+
+    Cell BatchSimulator::deal(std::size_t game) {
+        // a 7-bag kept as the mask of the pieces still in it, drawing one of them uniformly
+        if (bags[game] == 0) bags[game] = full_bag_mask;
+        std::uint32_t bag = bags[game];
+        // as many rounds as a full bag could need, so the random number of pieces skipped isn't a branch
+        const std::uint32_t skip = random_below(game, popcount(bag));
+        for (std::uint32_t i = 0; i < NUM_TETROMINOES - 1; i++)
+            bag &= i < skip ? bag - 1 : ~0u;
+        unsigned int kind = lowest_bit(bag);
+        bags[game] &= ~(1 << kind);
+        return static_cast<Cell>(kind);
+    }
+
+    bool BatchSimulator::spawn_blocked(std::size_t game) const {
+        // all the rows of the state, the empty ones past its height included, fall on the board or its padding
+        const TetrominoState &state = piece_state(pieces[game]);
+        std::int32_t overlap = 0;
+        for (std::size_t y = 0; y < TETROMINO_CELLS; y++) {
+            std::int32_t row = std::int32_t(state.rows[y]) << Simulation::spawn_pos.x;
+            overlap |= occupancy[tile_index(game, Simulation::spawn_pos.y + y, stored_rows)] & row;
+        }
+        return overlap != 0;
+    }
+
+    void BatchSimulator::end_game(std::size_t game) {
+        game_over[game] = 1;
+        // a game that is over has no piece, so the vector steps of the games next to it leave its board alone
+        for (std::size_t y = 0; y < TETROMINO_CELLS; y++) {
+            piece_rows[tile_index(game, y, TETROMINO_CELLS)] = 0;
+            spawn_rows[tile_index(game, y, TETROMINO_CELLS)] = 0;
+        }
+        piece_heights[game] = 0;
+        spawn_heights[game] = 0;
+    }
+
+    BatchSimulator::Board::row_type BatchSimulator::row(std::size_t game, std::size_t y) const {
+        return static_cast<Board::row_type>(occupancy[tile_index(game, y, stored_rows)]);
+    }
+
+    std::size_t BatchSimulator::num_active() const {
+        return std::count(game_over.begin(), game_over.begin() + num_games, 0);
+    }
+
+    void BatchSimulator::random_moves(BatchMove *moves) {
+        for (std::size_t game = 0; game < num_games; game++) {
+            if (game_over[game]) {
+                moves[game] = BatchMove{Rotation::NONE, 0};
+                continue;
+            }
+            Rotation rotation = static_cast<Rotation>(random_below(game, NUM_ROTATIONS));
+            unsigned int width = piece_state(pieces[game], rotation).width;
+            unsigned int column = random_below(game, Board::columns - width + 1);
+            moves[game] = BatchMove{rotation, static_cast<std::uint8_t>(column)};
+        }
+    }
+
+    void BatchSimulator::prepare_piece(std::size_t game, const BatchMove &move) {
+        // the unrotated piece at the spawn position is the fallback for a move that doesn't fit; a state's rows
+        // past its height are empty, so all of them are copied and the loop doesn't depend on the piece
+        const TetrominoState &spawn_state = piece_state(pieces[game]);
+        for (std::size_t y = 0; y < TETROMINO_CELLS; y++) {
+            spawn_rows[tile_index(game, y, TETROMINO_CELLS)] =
+                std::int32_t(spawn_state.rows[y]) << Simulation::spawn_pos.x;
+        }
+        spawn_heights[game] = spawn_state.height;
+
+        const TetrominoState &state = piece_state(pieces[game], move.rotation);
+        // a move off the board can't fit, so it takes the fallback right away
+        const bool on_board = move.column + state.width <= Board::columns;
+        const TetrominoState &placed_state = on_board ? state : spawn_state;
+        const unsigned int column = on_board ? move.column : Simulation::spawn_pos.x;
+        for (std::size_t y = 0; y < TETROMINO_CELLS; y++)
+            piece_rows[tile_index(game, y, TETROMINO_CELLS)] = std::int32_t(placed_state.rows[y]) << column;
+        piece_heights[game] = placed_state.height;
+    }
+
+    void BatchSimulator::drop_and_place(std::size_t lane) {
+        const std::size_t spawn_y = Simulation::spawn_pos.y;
+        const lane_vector zero = lanes_splat(0);
+        std::int32_t *board = &occupancy[tile_index(lane, 0, stored_rows)];
+        std::int32_t *tops = &column_tops[tile_index(lane, 0, Board::columns)];
+        std::int32_t *piece = &piece_rows[tile_index(lane, 0, TETROMINO_CELLS)];
+        const std::int32_t *spawn = &spawn_rows[tile_index(lane, 0, TETROMINO_CELLS)];
+
+        // the moves that don't fit where they start fall back to the unrotated piece
+        lane_vector blocked = collisions(board, piece, spawn_y);
+        lane_vector rows[TETROMINO_CELLS];
+        for (std::size_t dy = 0; dy < TETROMINO_CELLS; dy++) {
+            rows[dy] = lanes_select(blocked, lanes_load(&spawn[dy * LANE_WIDTH]), lanes_load(&piece[dy * LANE_WIDTH]));
+            lanes_store(&piece[dy * LANE_WIDTH], rows[dy]);
+        }
+        lane_vector height = lanes_select(blocked, lanes_load(&spawn_heights[lane]), lanes_load(&piece_heights[lane]));
+        // the lanes of games that are over have no piece
+        const lane_vector playing = ~(height == zero);
+
+        // The lowest and highest cell of the piece in each column, as the two bits of their row in the piece: a
+        // cell is the lowest of its column when no row below it covers that column, and the highest likewise.
+        const lane_vector below_2 = rows[3];
+        const lane_vector below_1 = below_2 | rows[2];
+        const lane_vector below_0 = below_1 | rows[1];
+        const lane_vector covered = below_0 | rows[0];
+        const lane_vector above_3 = rows[0] | rows[1] | rows[2];
+        const lane_vector lowest_bit_0 = (rows[1] & ~below_1) | rows[3];
+        const lane_vector lowest_bit_1 = (rows[2] & ~below_2) | rows[3];
+        const lane_vector highest_bit_0 = (rows[1] & ~rows[0]) | (rows[3] & ~above_3);
+        const lane_vector highest_bit_1 = (rows[2] & ~(rows[0] | rows[1])) | (rows[3] & ~above_3);
+
+        // Like Board::drop_distance, a piece above the surface of all its columns lands where the first of them
+        // stops it
+        const lane_vector one = lanes_splat(1);
+        // the columns a piece doesn't cover count as its cells being this far above them, which never stops it
+        const lane_vector far = lanes_splat(2 * Board::rows);
+        lane_vector distance = lanes_splat(Board::rows);
+        lane_vector tucked = zero;
+        for (std::size_t x = 0; x < Board::columns; x++) {
+            const lane_vector outside = ((covered >> x) & one) - one;
+            const lane_vector lowest = ((lowest_bit_0 >> x) & one) | (((lowest_bit_1 >> x) & one) << 1);
+            const lane_vector bottom = lanes_splat(spawn_y) + lowest - (outside & far);
+            const lane_vector top = lanes_load(&tops[x * LANE_WIDTH]);
+            tucked = tucked | (top <= bottom);
+            distance = lanes_min(distance, top - bottom - one);
+        }
+        lane_vector landing = lanes_splat(spawn_y) + distance;
+
+        if (lanes_any(tucked)) {
+            // a piece under an overhang falls row by row until its first collision instead
+            lane_vector falling = playing;
+            landing = lanes_splat(spawn_y);
+            const lane_vector bottom = lanes_splat(Board::rows);
+            for (std::size_t y = spawn_y + 1; y < Board::rows && lanes_any(falling); y++) {
+                lane_vector row_y = lanes_splat(y);
+                falling = falling & (row_y + height <= bottom) & ~collisions(board, piece, y);
+                landing = lanes_select(falling, row_y, landing);
+            }
+        }
+        landing = lanes_select(playing, landing, lanes_splat(Board::rows));
+        lanes_store(&landing_rows[lane], landing);
+
+        // each board row takes whichever row of the piece landed on it, if any; a lane without a piece lands
+        // below the board and ends above it
+        const lane_vector landing_end = (landing + lanes_splat(TETROMINO_CELLS)) & playing;
+        std::int32_t top = Board::rows;
+        std::int32_t bottom_row = 0;
+        for (std::size_t i = 0; i < LANE_WIDTH; i++) {
+            top = std::min(top, landing[i]);
+            bottom_row = std::max(bottom_row, landing_end[i]);
+        }
+        for (std::size_t y = top; y < std::min<std::size_t>(bottom_row, Board::rows); y++) {
+            lane_vector offset = lanes_splat(y) - landing;
+            lane_vector piece_row = zero;
+            for (std::size_t dy = 0; dy < TETROMINO_CELLS; dy++)
+                piece_row = piece_row | (rows[dy] & (offset == lanes_splat(dy)));
+            std::int32_t *row = &board[y * LANE_WIDTH];
+            lanes_store(row, lanes_load(row) | piece_row);
+        }
+
+        for (std::size_t x = 0; x < Board::columns; x++) {
+            std::int32_t *column_top = &tops[x * LANE_WIDTH];
+            const lane_vector outside = ((covered >> x) & one) - one;
+            const lane_vector highest = ((highest_bit_0 >> x) & one) | (((highest_bit_1 >> x) & one) << 1);
+            lanes_store(column_top, lanes_min(lanes_load(column_top), landing + highest + (outside & far)));
+        }
+    }
+
+    void BatchSimulator::clear_lines(std::size_t lane) {
+        const lane_vector full = lanes_splat(Board::full_row);
+        const lane_vector none = lanes_splat(-1);
+        std::int32_t *board = &occupancy[tile_index(lane, 0, stored_rows)];
+        lane_vector count = lanes_splat(0);
+        // only the rows the pieces landed on can have become full
+        std::size_t top = Board::rows;
+        std::size_t bottom = 0;
+        for (std::size_t i = 0; i < LANE_WIDTH; i++) {
+            if (landing_rows[lane + i] == std::int32_t(Board::rows)) continue;
+            top = std::min<std::size_t>(top, landing_rows[lane + i]);
+            bottom = std::max<std::size_t>(bottom, landing_rows[lane + i] + TETROMINO_CELLS);
+        }
+        bottom = std::min<std::size_t>(bottom, Board::rows);
+
+        // one piece fills at most as many rows as it has, each pass removes the lowest full row of every lane
+        for (std::size_t pass = 0; pass < TETROMINO_CELLS; pass++) {
+            lane_vector full_y = none;
+            for (std::size_t y = top; y < bottom; y++)
+                full_y = lanes_select(lanes_load(&board[y * LANE_WIDTH]) == full, lanes_splat(y), full_y);
+            lane_vector has_full = full_y != none;
+            if (!lanes_any(has_full)) break;
+
+            // the rows from the full one up move down by one, and the top one is emptied
+            for (std::size_t y = bottom - 1; y > 0; y--) {
+                std::int32_t *row = &board[y * LANE_WIDTH];
+                lane_vector shifted = has_full & (lanes_splat(y) <= full_y);
+                lanes_store(row, lanes_select(shifted, lanes_load(row - LANE_WIDTH), lanes_load(row)));
+            }
+            lanes_store(board, lanes_select(has_full, lanes_splat(0), lanes_load(board)));
+            count = count - has_full;
+        }
+        lanes_store(&cleared[lane], count);
+
+        if (!lanes_any(count)) return;
+        // removed rows can uncover holes anywhere below, so the tops are found again from the highest one down
+        std::int32_t *tops = &column_tops[tile_index(lane, 0, Board::columns)];
+        lane_vector highest = lanes_splat(Board::rows);
+        for (std::size_t x = 0; x < Board::columns; x++)
+            highest = lanes_min(highest, lanes_load(&tops[x * LANE_WIDTH]));
+        std::size_t highest_top = Board::rows;
+        for (std::size_t i = 0; i < LANE_WIDTH; i++)
+            highest_top = std::min<std::size_t>(highest_top, highest[i]);
+        find_column_tops(lane, highest_top);
+    }
+
+    void BatchSimulator::find_column_tops(std::size_t lane, std::size_t top) {
+        const lane_vector zero = lanes_splat(0);
+        const std::int32_t *board = &occupancy[tile_index(lane, 0, stored_rows)];
+        std::int32_t *tops = &column_tops[tile_index(lane, 0, Board::columns)];
+        for (std::size_t x = 0; x < Board::columns; x++) {
+            const lane_vector column = lanes_splat(1 << x);
+            lane_vector column_top = lanes_splat(Board::rows);
+            for (std::size_t y = Board::rows; y-- > top;) {
+                lane_vector occupied = ~((lanes_load(&board[y * LANE_WIDTH]) & column) == zero);
+                column_top = lanes_select(occupied, lanes_splat(y), column_top);
+            }
+            lanes_store(&tops[x * LANE_WIDTH], column_top);
+        }
+    }
+
+    void BatchSimulator::step(const BatchMove *moves) {
+        // A few vectors of games at a time from the move to the next piece: their rows stay in the cache between
+        // the scalar parts and the vector ones, and the pieces written one game at a time have left the store
+        // buffer by the time they are read back a vector at a time.
+        constexpr std::size_t games_per_chunk = 8 * LANE_WIDTH;
+        for (std::size_t chunk = 0; chunk < stride; chunk += games_per_chunk) {
+            const std::size_t chunk_end = std::min(chunk + games_per_chunk, stride);
+            for (std::size_t game = chunk; game < std::min(chunk_end, num_games); game++)
+                if (!game_over[game]) prepare_piece(game, moves[game]);
+
+            for (std::size_t lane = chunk; lane < chunk_end; lane += LANE_WIDTH) {
+                // whole vectors of games that are over are skipped, they only get more common as rollouts go on
+                auto is_over = [] (std::uint8_t over) { return over != 0; };
+                if (std::all_of(&game_over[lane], &game_over[lane] + LANE_WIDTH, is_over)) continue;
+                drop_and_place(lane);
+                clear_lines(lane);
+            }
+
+            for (std::size_t game = chunk; game < std::min(chunk_end, num_games); game++) {
+                if (game_over[game]) continue;
+                lines[game] += cleared[game];
+                scores[game] += points_for_lines(cleared[game]);
+                placed[game]++;
+                pieces[game] = deal(game);
+                if (spawn_blocked(game)) end_game(game);
+            }
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef BATCHSIM_H_
+#define BATCHSIM_H_
+#include "pcg.h"
+#include "sim.h"
+#include "tetro.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tetriskl {
+    // struktūra BatchMove ir viena gabala novietojums BatchSimulator spēlē: gabals tiek pagriezts, novietots
+    // kolonnā column (tā kreisā mala) parādīšanās rindā un nomests taisni uz leju
+    struct BatchMove {
+        Rotation rotation;
+        std::uint8_t column;
+    };
+
+    // Klase BatchSimulator vienlaikus spēlē daudzas neatkarīgas spēles, piemēram, Monte Carlo izspēlēm.
+    // Lauciņi tiek glabāti kā masīvu struktūra: katra vektora spēļu rinda y atrodas blakus atmiņā, tāpēc
+    // sadursmes, nomešana, novietošana, pilno rindu atrašana un rindu izņemšana notiek lane_width() spēlēm ar
+    // katru vektoru instrukciju. Kā Simulation::Board, arī šeit katrai kolonnai tiek glabāta tās augšējā aizņemtā
+    // rinda, tāpēc nomešanas attālumu parasti nosaka tikai kolonnu augstumi. Katras spēles gabalu ģenerators ir
+    // tikai PCG stāvoklis un maisa maska.
+    class BatchSimulator {
+    public:
+        using Board = Simulation::Board;
+    private:
+        // empty rows below the board, so all four rows of a piece can be read without checking the bottom
+        constexpr static std::size_t padding_rows = TETROMINO_CELLS - 1;
+        constexpr static std::size_t stored_rows = Board::rows + padding_rows;
+
+        std::size_t num_games;
+        // the games rounded up to whole vectors; the extra lanes are games that are over from the start
+        std::size_t stride;
+        // the rows of every game's board, a block of lane_width() games at a time (see tile_index in batchsim.cpp)
+        std::vector<std::int32_t> occupancy;
+        // the highest occupied row of every column of every game, or Board::rows when it's empty, laid out the same
+        std::vector<std::int32_t> column_tops;
+        // the rows and height of every game's piece, written at the start of each step and empty once the game is
+        // over, and the lines it cleared
+        std::vector<std::int32_t> piece_rows;
+        std::vector<std::int32_t> spawn_rows;
+        std::vector<std::int32_t> piece_heights;
+        std::vector<std::int32_t> spawn_heights;
+        std::vector<std::int32_t> cleared;
+        // the highest row each game's piece landed on
+        std::vector<std::int32_t> landing_rows;
+
+        std::vector<Cell> pieces;
+        // every game draws from a stream of its own, split off one generator seeded with the seed
+        std::vector<Pcg32> rngs;
+        std::vector<std::uint8_t> bags;
+        std::vector<std::uint8_t> game_over;
+        std::vector<unsigned int> lines;
+        std::vector<unsigned int> scores;
+        std::vector<unsigned int> placed;
+
+        std::uint32_t random_below(std::size_t game, std::uint32_t bound);
+        Cell deal(std::size_t game);
+        bool spawn_blocked(std::size_t game) const;
+        void end_game(std::size_t game);
+        void prepare_piece(std::size_t game, const BatchMove &move);
+        void drop_and_place(std::size_t lane);
+        void clear_lines(std::size_t lane);
+        void find_column_tops(std::size_t lane, std::size_t top);
+    public:
+        // konstruktors BatchSimulator(num_games, seed) sāk num_games spēles ar tukšiem lauciņiem, katrai no tām
+        // atvasinot savu gabalu secību no sēklas seed
+        BatchSimulator(std::size_t num_games, std::uint64_t seed);
+
+        // funkcija lane_width() atgriež, cik spēles tiek apstrādātas ar vienu vektoru instrukciju
+        static std::size_t lane_width();
+
+        std::size_t size() const { return num_games; }
+
+        Cell get_piece(std::size_t game) const { return pieces[game]; }
+        bool is_game_over(std::size_t game) const { return game_over[game] != 0; }
+        unsigned int get_lines(std::size_t game) const { return lines[game]; }
+        unsigned int get_score(std::size_t game) const { return scores[game]; }
+        // metode get_pieces(game) atgriež spēlē game novietoto gabalu skaitu
+        unsigned int get_pieces(std::size_t game) const { return placed[game]; }
+        // metode row(game, y) atgriež spēles game lauciņa rindas y aizņemtības masku
+        Board::row_type row(std::size_t game, std::size_t y) const;
+        // metode num_active() atgriež spēļu skaitu, kas vēl nav beigušās
+        std::size_t num_active() const;
+
+        // metode random_moves(moves) ieraksta moves katrai spēlei nejaušu pagriezienu un kolonnu, kurā gabals ietilpst
+        void random_moves(BatchMove *moves);
+
+        // metode step(moves) katrā vēl nebeigtā spēlē game novieto pašreizējo gabalu ar moves[game], izņem pilnās
+        // rindas un izdala nākamo gabalu; ja pagriezto gabalu nevar novietot parādīšanās rindā, tas tiek nomests
+        // nepagriezts no parādīšanās vietas. Spēle beidzas, kad nākamo gabalu nevar novietot parādīšanās vietā.
+        void step(const BatchMove *moves);
+    };
+}
+
+#endif // BATCHSIM_H_
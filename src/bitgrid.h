@@ -0,0 +1,235 @@
+#ifndef BITGRID_H_
+#define BITGRID_H_
+#include "bitops.h"
+#include "tetro.h"
+#include "zobrist.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <SFML/System.hpp>
+
+namespace tetriskl {
+    // klase BitCellGrid glabā lauciņa aizņemtību kā vienu bitu masku katrai rindai (bits x atbilst kolonnai x),
+    // bet šūnu krāsas atsevišķā StaticCellGrid, ko izmanto tikai zīmēšanai. Papildus tiek uzturēta katras
+    // kolonnas augstākā aizņemtā rinda, lai gabala krišanas attālumu varētu aprēķināt tikai pēc tā kolonnām,
+    // un aizņemtības Zobrist jaucējvērtība, ko atjauno pa daļām katrā izmaiņā.
+    template<std::size_t Columns, std::size_t Rows>
+    class BitCellGrid final: public CellGrid {
+    public:
+        using row_type = std::uint32_t;
+        static_assert(Columns < sizeof(row_type) * 8, "row does not fit in row_type");
+        static_assert(Rows < 256, "column tops do not fit in std::uint8_t");
+        static_assert(Columns <= ZOBRIST_COLUMNS && Rows <= ZOBRIST_ROWS, "board does not fit in the Zobrist table");
+
+        constexpr static unsigned int columns = Columns;
+        constexpr static unsigned int rows = Rows;
+        constexpr static row_type full_row = (row_type(1) << Columns) - 1;
+
+    private:
+        array<row_type, Rows> occupancy;
+        // the topmost occupied row of every column, or Rows for an empty column
+        array<std::uint8_t, Columns> column_tops;
+        StaticCellGrid<Columns, Rows> colors;
+        std::uint64_t hash;
+
+        // ORs mask into row y, keeping the column tops and the hash in step with it
+        void add_to_row(std::size_t y, row_type mask) {
+            hash ^= Zobrist::row_key(y, mask & ~occupancy[y]);
+            occupancy[y] |= mask;
+            raise_column_tops(y, mask);
+        }
+
+        void raise_column_tops(std::size_t y, row_type mask) {
+            for (std::size_t x = 0; x < Columns; x++)
+                if (((mask >> x) & 1) && y < column_tops[x])
+                    column_tops[x] = y;
+        }
+
+        void find_column_top(std::size_t x) {
+            std::size_t y = 0;
+            while (y < Rows && !((occupancy[y] >> x) & 1)) y++;
+            column_tops[x] = y;
+        }
+
+    public:
+        BitCellGrid() : occupancy(), column_tops(), colors(), hash(0) {
+            occupancy.fill(0);
+            column_tops.fill(Rows);
+        }
+
+        Cell& operator[](sf::Vector2u) override {
+            throw std::logic_error("cannot use non-const operator[] with BitCellGrid, use set()");
+        }
+
+        const Cell& operator[](sf::Vector2u point) const override {
+            return colors[point];
+        }
+
+        sf::Vector2u size() const override { return sf::Vector2u(Columns, Rows); }
+
+        // metode row_masks() atgriež visu rindu aizņemtības maskas
+        const array<row_type, Rows>& row_masks() const {
+            return occupancy;
+        }
+
+        // metode row(y) atgriež rindas y aizņemtības masku
+        row_type row(std::size_t y) const {
+            return occupancy[y];
+        }
+
+        // metode column_top(x) atgriež kolonnas x augstāko aizņemto rindu vai rows, ja kolonna ir tukša
+        unsigned int column_top(std::size_t x) const {
+            return column_tops[x];
+        }
+
+        // metode get_hash() atgriež lauciņa aizņemtības Zobrist jaucējvērtību, kas sakrīt ar
+        // Zobrist::board_key(row_masks())
+        std::uint64_t get_hash() const {
+            return hash;
+        }
+
+        // metode set(point, cell) ieraksta šūnu vietā point, atjaunojot arī masku
+        void set(sf::Vector2u point, Cell cell) {
+            row_type bit = row_type(1) << point.x;
+            row_type before = occupancy[point.y];
+            if (cell != Cell::N)
+                occupancy[point.y] |= bit;
+            else
+                occupancy[point.y] &= ~bit;
+            hash ^= Zobrist::row_key(point.y, before ^ occupancy[point.y]);
+            colors[point] = cell;
+            find_column_top(point.x);
+        }
+
+        template <typename Tile>
+        bool can_place(sf::Vector2u pos, const Tile &tile) const {
+            sf::Vector2u tile_size = tile.size();
+            if (pos.x + tile_size.x > Columns) return false;
+            if (pos.y + tile_size.y > Rows) return false;
+            for (std::size_t y = 0; y < tile_size.y; y++) {
+                if (occupancy[pos.y + y] & (row_mask(tile, y) << pos.x))
+                    return false;
+            }
+
+            return true;
+        }
+
+        template <typename Tile>
+        void place(sf::Vector2u pos, const Tile &tile) {
+            sf::Vector2u tile_size = tile.size();
+            for (std::size_t y = 0; y < tile_size.y; y++) {
+                row_type mask = 0;
+                for (std::size_t x = 0; x < tile_size.x; x++) {
+                    sf::Vector2u tilepos(x, y);
+                    Cell cell = tile[tilepos];
+                    if (cell == Cell::N) continue;
+                    colors[pos + tilepos] = cell;
+                    mask |= row_type(1) << x;
+                }
+                add_to_row(pos.y + y, mask << pos.x);
+            }
+        }
+
+        bool can_place(sf::Vector2u pos, const Tetromino &piece) const {
+            const TetrominoState &state = piece.state();
+            if (pos.x + state.width > Columns) return false;
+            if (pos.y + state.height > Rows) return false;
+            for (std::size_t y = 0; y < state.height; y++) {
+                if (occupancy[pos.y + y] & (row_type(state.rows[y]) << pos.x))
+                    return false;
+            }
+
+            return true;
+        }
+
+        void place(sf::Vector2u pos, const Tetromino &piece) {
+            if (piece.type() == Cell::N) return;
+            const TetrominoState &state = piece.state();
+            for (const TilePoint &p : state.cells)
+                colors[pos + sf::Vector2u(p.x, p.y)] = piece.type();
+            for (std::size_t y = 0; y < state.height; y++)
+                add_to_row(pos.y + y, row_type(state.rows[y]) << pos.x);
+        }
+
+        // metode drop_distance(pos, piece) atgriež, par cik rindām gabals piece var nokrist no vietas pos.
+        // Ja gabals atrodas virs visām savu kolonnu virsmām, to nosaka tikai kolonnu augstumi.
+        unsigned int drop_distance(sf::Vector2u pos, const Tetromino &piece) const {
+            const TetrominoState &state = piece.state();
+            unsigned int distance = Rows;
+            for (std::size_t x = 0; x < state.width; x++) {
+                unsigned int bottom = pos.y + state.column_bottom[x];
+                unsigned int top = column_tops[pos.x + x];
+                if (top <= bottom) {
+                    // the piece is tucked under an overhang, so fall back to testing row by row
+                    distance = 0;
+                    while (can_place(sf::Vector2u(pos.x, pos.y + distance + 1), piece)) distance++;
+                    return distance;
+                }
+                distance = std::min(distance, top - bottom - 1);
+            }
+            return distance;
+        }
+
+        // metode row_full(y) pārbauda, vai rinda y ir pilnībā aizpildīta
+        bool row_full(std::size_t y) const {
+            return occupancy[y] == full_row;
+        }
+
+        // metode clear_row(y) iztukšo rindu y, nepārvietojot pārējās
+        void clear_row(std::size_t y) {
+            hash ^= Zobrist::row_key(y, occupancy[y]);
+            occupancy[y] = 0;
+            (colors.begin() + y)->fill(Cell::N);
+            for (std::size_t x = 0; x < Columns; x++)
+                if (column_tops[x] == y) find_column_top(x);
+        }
+
+        // metode remove_full_rows(begin, end) izņem visas pilnās rindas starp begin (ieskaitot) un end
+        // (neieskaitot) un atgriež to skaitu
+        unsigned int remove_full_rows(std::size_t begin, std::size_t end) {
+            unsigned int removed = 0;
+            // removing a row only moves the ones above it, so going down keeps the rest in place
+            for (std::size_t y = begin; y < end; y++) {
+                if (!row_full(y)) continue;
+                remove_row(y);
+                removed++;
+            }
+            return removed;
+        }
+
+        // metode remove_row(y) izņem rindu y, nobīdot visas virs tās esošās rindas par vienu uz leju
+        void remove_row(std::size_t y) {
+            // every row above y moves down by one, so its cells swap the keys of row k for those of row k + 1
+            hash ^= Zobrist::row_key(y, occupancy[y]);
+            for (std::size_t k = 0; k < y; k++)
+                hash ^= Zobrist::row_key(k, occupancy[k]) ^ Zobrist::row_key(k + 1, occupancy[k]);
+            std::copy_backward(occupancy.begin(), occupancy.begin() + y, occupancy.begin() + y + 1);
+            occupancy[0] = 0;
+            auto it = colors.begin();
+            std::copy_backward(it, it + y, it + y + 1);
+            it->fill(Cell::N);
+            for (std::size_t x = 0; x < Columns; x++) {
+                if (column_tops[x] < y)
+                    column_tops[x]++;
+                else if (column_tops[x] == y)
+                    find_column_top(x);
+            }
+        }
+
+        // funkcija row_mask(tile, y) atgriež lauciņa tile rindas y aizņemtības masku
+        template <typename Tile>
+        static row_type row_mask(const Tile &tile, std::size_t y) {
+            row_type mask = 0;
+            sf::Vector2u tile_size = tile.size();
+            for (std::size_t x = 0; x < tile_size.x; x++)
+                if (tile[sf::Vector2u(x, y)] != Cell::N)
+                    mask |= row_type(1) << x;
+            return mask;
+        }
+    };
+}
+
+#endif // BITGRID_H_
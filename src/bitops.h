@@ -0,0 +1,30 @@
+#ifndef BITOPS_H_
+#define BITOPS_H_
+
+#include <cstdint>
+
+namespace tetriskl {
+    // funkcija popcount(mask) atgriež iestatīto bitu skaitu maskā mask
+    inline unsigned int popcount(std::uint32_t mask) {
+#if defined(__GNUC__)
+        return __builtin_popcount(mask);
+#else
+        unsigned int count = 0;
+        for (; mask != 0; mask &= mask - 1) count++;
+        return count;
+#endif
+    }
+
+    // funkcija lowest_bit(mask) atgriež zemākā iestatītā bita numuru maskā mask, kam jābūt nenulles
+    inline unsigned int lowest_bit(std::uint32_t mask) {
+#if defined(__GNUC__)
+        return __builtin_ctz(mask);
+#else
+        unsigned int bit = 0;
+        for (; !(mask & 1); mask >>= 1) bit++;
+        return bit;
+#endif
+    }
+}
+
+#endif // BITOPS_H_
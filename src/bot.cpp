@@ -0,0 +1,176 @@
+#include "bot.h"
+#include "zobrist.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <SFML/System.hpp>
+
+namespace tetriskl {
+    using Board = Simulation::Board;
+    using row_type = Board::row_type;
+
+    BoardFeatures extract_features(const BoardRows &rows) {
+        constexpr row_type full = Board::full_row;
+        constexpr row_type left_wall = 1;
+        constexpr row_type right_wall = row_type(1) << (Board::columns - 1);
+
+        BoardFeatures features{};
+        std::array<unsigned int, Board::columns> heights{};
+        // streaks[k] holds the columns whose open well reaches at least k + 1 rows down to the previous row
+        std::array<row_type, Board::rows> streaks{};
+        std::size_t num_streaks = 0;
+
+        // empty rows above the stack only ever have the two transitions at the walls
+        std::size_t y = 0;
+        while (y < Board::rows && rows[y] == 0) y++;
+        features.row_transitions = 2 * y;
+
+        row_type covered = 0;
+        row_type above = 0;
+        for (; y < Board::rows; y++) {
+            const row_type row = rows[y];
+
+            // the first filled cell from the top gives the column's height
+            for (row_type tops = row & ~covered; tops != 0; tops &= tops - 1)
+                heights[lowest_bit(tops)] = Board::rows - y;
+            features.holes += popcount(~row & covered & full);
+
+            // the walls count as filled on both ends of the row
+            const row_type walled = (row << 1) | 1 | (row_type(1) << (Board::columns + 1));
+            features.row_transitions += popcount((walled ^ (walled >> 1)) & ((row_type(1) << (Board::columns + 1)) - 1));
+            features.column_transitions += popcount(row ^ above);
+
+            // open cells with both neighbours filled, each one deeper in the well adds its depth
+            const row_type well = ~row & ~covered & full & ((row << 1) | left_wall) & ((row >> 1) | right_wall);
+            row_type carry = well;
+            std::size_t k = 0;
+            while (carry != 0) {
+                row_type longer = k < num_streaks ? streaks[k] : 0;
+                streaks[k++] = carry;
+                features.wells += popcount(carry);
+                carry = well & longer;
+            }
+            num_streaks = k;
+
+            covered |= row;
+            above = row;
+        }
+        // the floor counts as filled too
+        features.column_transitions += popcount(above ^ full);
+
+        for (std::size_t x = 0; x < Board::columns; x++) {
+            features.aggregate_height += heights[x];
+            if (x + 1 < Board::columns)
+                features.bumpiness += std::abs((int)heights[x] - (int)heights[x + 1]);
+        }
+        return features;
+    }
+
+    float evaluate(const BoardRows &rows, unsigned int lines_cleared, const BotWeights &weights) {
+        BoardFeatures features = extract_features(rows);
+        return weights.aggregate_height * features.aggregate_height
+            + weights.holes * features.holes
+            + weights.bumpiness * features.bumpiness
+            + weights.wells * features.wells
+            + weights.row_transitions * features.row_transitions
+            + weights.column_transitions * features.column_transitions
+            + weights.lines_cleared * lines_cleared;
+    }
+
+    unsigned int apply_placement(BoardRows &rows, const Placement &placement) {
+        const TetrominoState &state = placement.piece.state();
+        unsigned int lines_cleared = 0;
+        for (std::size_t y = 0; y < state.height; y++) {
+            std::size_t row = placement.pos.y + y;
+            rows[row] |= row_type(state.rows[y]) << placement.pos.x;
+            if (rows[row] != Board::full_row) continue;
+
+            // the rows of the piece go downwards, so removing this one leaves the next ones in place
+            std::copy_backward(rows.begin(), rows.begin() + row, rows.begin() + row + 1);
+            rows[0] = 0;
+            lines_cleared++;
+        }
+        return lines_cleared;
+    }
+
+    unsigned int apply_placement(BoardRows &rows, const Placement &placement, std::uint64_t &hash) {
+        const TetrominoState &state = placement.piece.state();
+        unsigned int lines_cleared = 0;
+        for (std::size_t y = 0; y < state.height; y++) {
+            std::size_t row = placement.pos.y + y;
+            const row_type added = row_type(state.rows[y]) << placement.pos.x;
+            hash ^= Zobrist::row_key(row, added);
+            rows[row] |= added;
+            if (rows[row] != Board::full_row) continue;
+
+            // the rows above move down by one, taking the keys of the row below instead of their own
+            hash ^= Zobrist::row_key(row, rows[row]);
+            for (std::size_t k = 0; k < row; k++)
+                hash ^= Zobrist::row_key(k, rows[k]) ^ Zobrist::row_key(k + 1, rows[k]);
+            std::copy_backward(rows.begin(), rows.begin() + row, rows.begin() + row + 1);
+            rows[0] = 0;
+            lines_cleared++;
+        }
+        return lines_cleared;
+    }
+
+    Bot::Bot(const BotWeights &weights)
+        : weights(weights),
+          generator(),
+          next_generator(),
+          path(),
+          table(nullptr) {}
+
+    const std::vector<Action>& Bot::choose(const BoardRows &rows, const Tetromino &piece,
+                                           const Tetromino &next_piece, sf::Vector2u pos) {
+        // losing the game scores below every board that can still be played on
+        constexpr float game_over_score = std::numeric_limits<float>::lowest();
+
+        path.clear();
+        const std::vector<Placement> &placements = generator.generate(rows, piece, pos);
+        const Placement *best = nullptr;
+        float best_score = game_over_score;
+        const std::uint64_t hash = table != nullptr ? Zobrist::board_key(rows) : 0;
+        for (const Placement &placement : placements) {
+            BoardRows after = rows;
+            std::uint64_t after_hash = hash;
+            // the hash is only needed for the table
+            unsigned int lines_cleared = table != nullptr ? apply_placement(after, placement, after_hash)
+                                                          : apply_placement(after, placement);
+
+            float score = game_over_score;
+            if (next_piece.type() == Cell::N) {
+                score = evaluate(after, lines_cleared, weights);
+            } else {
+                // the continuation leaves out this placement's lines, so placements that leave the same board
+                // can share it
+                const std::uint64_t key = after_hash ^ Zobrist::piece_key((std::size_t)next_piece.type());
+                TableEntry entry;
+                float continuation = game_over_score;
+                if (table != nullptr && table->probe(key, entry)) {
+                    continuation = entry.score;
+                } else {
+                    for (const Placement &next : next_generator.generate(after, next_piece, Simulation::spawn_pos)) {
+                        BoardRows next_after = after;
+                        unsigned int next_lines_cleared = apply_placement(next_after, next);
+                        continuation = std::max(continuation, evaluate(next_after, next_lines_cleared, weights));
+                    }
+                    if (table != nullptr)
+                        table->store(key, TableEntry{continuation, 1, 0});
+                }
+                if (continuation != game_over_score)
+                    score = continuation + weights.lines_cleared * lines_cleared;
+            }
+
+            if (best == nullptr || score > best_score) {
+                best = &placement;
+                best_score = score;
+            }
+        }
+
+        if (best != nullptr)
+            generator.get_path(*best, path);
+        return path;
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef BOT_H_
+#define BOT_H_
+#include "movegen.h"
+#include "sim.h"
+#include "tetro.h"
+#include "transtable.h"
+
+#include <cstdint>
+
+#include <vector>
+#include <SFML/System.hpp>
+
+namespace tetriskl {
+    // struktūra BoardFeatures satur lauciņa īpašības, pēc kurām robots vērtē novietojumus
+    struct BoardFeatures {
+        // visu kolonnu augstumu summa
+        unsigned int aggregate_height;
+        // tukšās šūnas, virs kurām kolonnā ir aizņemta šūna
+        unsigned int holes;
+        // blakus esošo kolonnu augstumu starpību summa
+        unsigned int bumpiness;
+        // aku dziļumu summa, kur aka dziļumā d tiek skaitīta kā 1 + 2 + ... + d
+        unsigned int wells;
+        // pāreju skaits starp tukšām un aizņemtām šūnām rindās un kolonnās, sienas un grīdu skaitot kā aizņemtas
+        unsigned int row_transitions;
+        unsigned int column_transitions;
+    };
+
+    // struktūra BotWeights satur katras īpašības svaru novietojuma vērtējumā
+    struct BotWeights {
+        float aggregate_height;
+        float holes;
+        float bumpiness;
+        float wells;
+        float row_transitions;
+        float column_transitions;
+        float lines_cleared;
+    };
+
+    constexpr BotWeights default_bot_weights{-0.51f, -7.9f, -0.18f, -3.39f, -3.22f, -9.35f, 3.42f};
+
+    // funkcija extract_features(rows) aprēķina lauciņa īpašības tikai ar rindu bitu maskām
+    BoardFeatures extract_features(const BoardRows &rows);
+
+    // funkcija evaluate(rows, lines_cleared, weights) novērtē lauciņu, kurā tikko notīrītas lines_cleared rindas
+    float evaluate(const BoardRows &rows, unsigned int lines_cleared, const BotWeights &weights);
+
+    // funkcija apply_placement(rows, placement) novieto gabalu lauciņā rows, izņem pilnās rindas un atgriež to skaitu
+    unsigned int apply_placement(BoardRows &rows, const Placement &placement);
+    // funkcija apply_placement(rows, placement, hash) dara to pašu, atjaunojot arī lauciņa Zobrist jaucējvērtību hash
+    unsigned int apply_placement(BoardRows &rows, const Placement &placement, std::uint64_t &hash);
+
+    // Klase Bot izvēlas, kur novietot krītošo gabalu: tā izmēģina visus gabala novietojumus un katram no tiem
+    // visus nākamā gabala novietojumus, un izvēlas to, kura labākais turpinājums iegūst augstāko vērtējumu.
+    class Bot {
+    private:
+        BotWeights weights;
+        MoveGenerator generator;
+        MoveGenerator next_generator;
+        std::vector<Action> path;
+        TranspositionTable *table;
+    public:
+        explicit Bot(const BotWeights &weights = default_bot_weights);
+
+        const BotWeights& get_weights() const { return weights; }
+        void set_weights(const BotWeights &weights) { this->weights = weights; }
+
+        // metode set_table(table) liek robotam saglabāt un meklēt tabulā table katra novietojuma labāko
+        // turpinājumu; nullptr to izslēdz. Tabulu var dalīt vairāki roboti ar vienādiem svariem, arī dažādos
+        // pavedienos, bet, mainot svarus, tā ir jāiztīra.
+        void set_table(TranspositionTable *table) { this->table = table; }
+
+        // metode choose(board, piece, next_piece, pos) atrod labāko novietojumu gabalam piece pozīcijā pos un
+        // atgriež darbības, kas to tur noved, beidzot ar HARD_DROP; tukšs saraksts nozīmē, ka novietojuma nav.
+        // Rezultāts paliek derīgs līdz nākamajam izsaukumam.
+        const std::vector<Action>& choose(const BoardRows &rows, const Tetromino &piece,
+                                          const Tetromino &next_piece, sf::Vector2u pos);
+        const std::vector<Action>& choose(const Simulation::Board &board, const Tetromino &piece,
+                                          const Tetromino &next_piece, sf::Vector2u pos) {
+            return choose(board.row_masks(), piece, next_piece, pos);
+        }
+    };
+}
+
+#endif // BOT_H_
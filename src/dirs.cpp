@@ -1,5 +1,11 @@
 #include "dirs.h"
+#include <cerrno>
 #include <stdexcept>
+#ifdef WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
 
 namespace tetriskl {
 #ifdef WIN32
@@ -15,6 +21,18 @@ namespace tetriskl {
         return std::string(std::move(path), 0, idx);
     }
 
+    std::string join_path(const std::string &directory, const std::string &name) {
+        return directory + PATH_SEPARATOR + name;
+    }
+
+    bool make_directory(const std::string &path) {
+#ifdef WIN32
+        return _mkdir(path.c_str()) == 0 || errno == EEXIST;
+#else
+        return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+    }
+
     ResourceLocator::ResourceLocator(int argc, const char *argv[]) {
         if (argc < 1)
             throw std::out_of_range("didn't receive the program name");
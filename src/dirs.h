@@ -3,6 +3,11 @@
 #include <string>
 
 namespace tetriskl {
+    // funkcija join_path(directory, name) atgriež ceļu uz failu name mapē directory
+    std::string join_path(const std::string &directory, const std::string &name);
+    // funkcija make_directory(path) izveido mapi path, ja tās vēl nav, un atgriež, vai tā tagad ir
+    bool make_directory(const std::string &path);
+
     class ResourceLocator {
     private:
         std::string asset_dir;
@@ -0,0 +1,105 @@
+#include "finesse.h"
+#include "zobrist.h"
+
+namespace tetriskl {
+    void FinesseTotals::add(const PieceFinesse &piece) {
+        pieces++;
+        if (!piece.reachable) {
+            unreachable++;
+            return;
+        }
+        inputs += piece.inputs;
+        minimum += piece.minimum;
+        wasted += piece.wasted();
+        if (piece.wasted() > 0) faults++;
+    }
+
+    void FinesseTotals::add(const FinesseTotals &totals) {
+        pieces += totals.pieces;
+        unreachable += totals.unreachable;
+        inputs += totals.inputs;
+        minimum += totals.minimum;
+        wasted += totals.wasted;
+        faults += totals.faults;
+    }
+
+    FinesseAnalyzer::FinesseAnalyzer() : generator(), path(), memo(), searches(0), lookups(0) {}
+
+    std::uint64_t FinesseAnalyzer::cells_key(const Tetromino &piece, sf::Vector2u pos) {
+        const TetrominoState &state = piece.state();
+        std::uint64_t key = 0;
+        for (std::size_t y = 0; y < state.height; y++)
+            key ^= Zobrist::row_key(pos.y + y, std::uint32_t(state.rows[y]) << pos.x);
+        return key;
+    }
+
+    const std::vector<FinesseAnalyzer::Reach>& FinesseAnalyzer::search(const Simulation::Board &board,
+                                                                        const Tetromino &piece) {
+        lookups++;
+        // every piece starts from the spawn position in its first rotation, so the board and the kind are enough
+        std::uint64_t key = board.get_hash() ^ Zobrist::piece_key(static_cast<std::size_t>(piece.type()));
+        auto found = memo.find(key);
+        if (found != memo.end()) return found->second;
+
+        searches++;
+        if (memo.size() >= FinesseAnalyzer::max_memo_entries) memo.clear();
+        std::vector<Reach> &reaches = memo[key];
+        for (const Placement &placement : generator.generate(board, piece, Simulation::spawn_pos)) {
+            generator.get_path(placement, path);
+            reaches.push_back(Reach{cells_key(placement.piece, placement.pos),
+                                    static_cast<unsigned int>(path.size())});
+        }
+        return reaches;
+    }
+
+    void FinesseAnalyzer::score_piece(PieceFinesse &finesse, const Simulation::Board &board, bool hard_dropped) {
+        std::uint64_t cells = cells_key(finesse.piece, finesse.pos);
+        for (const Reach &reach : search(board, Tetromino(finesse.piece.type()))) {
+            if (reach.cells != cells) continue;
+            // the shortest path ends in a hard drop, which gravity does for free
+            finesse.minimum = hard_dropped ? reach.length : reach.length - 1;
+            finesse.reachable = true;
+            return;
+        }
+    }
+
+    FinesseReport FinesseAnalyzer::analyze(const Replay &replay) {
+        FinesseReport report{};
+        Simulation sim(replay.header.seed, replay.header.rules);
+        ReplayInput input(replay);
+        std::vector<Action> actions;
+
+        Simulation::Board spawn_board = sim.get_board();
+        PieceFinesse current{sim.get_frame(), sim.get_falling_piece(), sf::Vector2u(), 0, 0, false};
+        // the placement a lock leaves is where the piece would have landed just before it
+        auto finish_piece = [&] (const Tetromino &piece, sf::Vector2u pos, bool hard_dropped) {
+            current.piece = piece;
+            current.pos = pos;
+            score_piece(current, spawn_board, hard_dropped);
+            report.pieces.push_back(current);
+            report.totals.add(current);
+
+            spawn_board = sim.get_board();
+            current = PieceFinesse{sim.get_frame(), sim.get_falling_piece(), sf::Vector2u(), 0, 0, false};
+        };
+
+        while (!input.finished(sim.get_frame()) && !sim.is_game_over()) {
+            actions.clear();
+            input.actions_at(sim.get_frame(), actions);
+            // the actions go in one by one, because any after a hard drop already move the next piece
+            for (Action action : actions) {
+                current.inputs++;
+                Tetromino piece = sim.get_falling_piece();
+                sf::Vector2u landing = sim.get_landing_pos();
+                if (sim.apply_action(action).piece_locked)
+                    finish_piece(piece, landing, action == Action::HARD_DROP);
+            }
+
+            Tetromino piece = sim.get_falling_piece();
+            sf::Vector2u landing = sim.get_landing_pos();
+            if (sim.advance().piece_locked)
+                finish_piece(piece, landing, false);
+        }
+        return report;
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef FINESSE_H_
+#define FINESSE_H_
+#include "movegen.h"
+#include "replay.h"
+#include "sim.h"
+#include "tetro.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <SFML/System.hpp>
+
+namespace tetriskl {
+    // struktūra PieceFinesse salīdzina viena gabala ievadi ar īsāko ievadi, kas to novieto tajā pašā vietā
+    struct PieceFinesse {
+        std::uint64_t spawn_frame;
+        Tetromino piece;
+        sf::Vector2u pos;
+        // the actions pressed while the piece was in play
+        unsigned int inputs;
+        // the fewest actions that place it the same way, without the hard drop when gravity locked it instead
+        unsigned int minimum;
+        // false when the search can't reach the placement, which only gravity moving the piece can cause
+        bool reachable;
+
+        // metode wasted() atgriež liekās darbības; gravitācijas dēļ spēlētājs var iztikt arī ar mazāk
+        unsigned int wasted() const { return reachable && inputs > minimum ? inputs - minimum : 0; }
+    };
+
+    // struktūra FinesseTotals ir vairāku gabalu kopsavilkums
+    struct FinesseTotals {
+        std::uint64_t pieces;
+        std::uint64_t unreachable;
+        std::uint64_t inputs;
+        std::uint64_t minimum;
+        std::uint64_t wasted;
+        // pieces with at least one wasted action
+        std::uint64_t faults;
+
+        void add(const PieceFinesse &piece);
+        void add(const FinesseTotals &totals);
+    };
+
+    // struktūra FinesseReport ir vienas spēles analīze
+    struct FinesseReport {
+        std::vector<PieceFinesse> pieces;
+        FinesseTotals totals;
+    };
+
+    // Klase FinesseAnalyzer atkārto ierakstītu spēli un katram gabalam salīdzina spēlētāja darbības ar īsāko
+    // MoveGenerator ceļu no parādīšanās vietas uz to pašu gala novietojumu. Visi novietojumi no viena lauciņa un
+    // gabala veida tiek atrasti ar vienu meklēšanu un atcerēti pēc lauciņa Zobrist jaucējvērtības, tāpēc
+    // atkārtotas pozīcijas (piemēram, vienādi spēļu sākumi) meklēšanu neprasa. Viens objekts jāizmanto vienā
+    // pavedienā, bet atkārtoti, lai atmiņa paliktu derīga starp spēlēm.
+    class FinesseAnalyzer {
+    private:
+        // the shortest path to every placement of one search, by the cells the placement covers
+        struct Reach {
+            std::uint64_t cells;
+            unsigned int length;
+        };
+
+        MoveGenerator generator;
+        std::vector<Action> path;
+        std::unordered_map<std::uint64_t, std::vector<Reach>> memo;
+        std::uint64_t searches;
+        std::uint64_t lookups;
+        // past this many searches the memo starts over, so it can't grow without bound over a large archive
+        constexpr static std::size_t max_memo_entries = 1 << 16;
+
+        const std::vector<Reach>& search(const Simulation::Board &board, const Tetromino &piece);
+        void score_piece(PieceFinesse &finesse, const Simulation::Board &board, bool hard_dropped);
+    public:
+        FinesseAnalyzer();
+
+        // metode analyze(replay) atkārto ierakstu replay un novērtē katru tajā nofiksēto gabalu
+        FinesseReport analyze(const Replay &replay);
+
+        // metodes get_searches() un get_lookups() atgriež veikto meklēšanu un visu vaicājumu skaitu
+        std::uint64_t get_searches() const { return searches; }
+        std::uint64_t get_lookups() const { return lookups; }
+
+        // funkcija cells_key(piece, pos) atgriež gabala piece pozīcijā pos aizņemto šūnu Zobrist atslēgu, kas
+        // vienāda visiem novietojumiem ar tām pašām šūnām
+        static std::uint64_t cells_key(const Tetromino &piece, sf::Vector2u pos);
+    };
+}
+
+#endif // FINESSE_H_
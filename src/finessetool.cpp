@@ -0,0 +1,111 @@
+#include "finesse.h"
+#include "replay.h"
+#include "workpool.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// tetriskl-finesse output replay...
+//
+// Analyzes the input of every given recording on every core: each piece's actions are compared with the
+// fewest that place it the same way from where it spawned. The totals over all recordings are printed, and
+// the file output gets every recording's totals followed by one line per piece, so wasteful habits can be
+// found in a whole archive of games at once.
+
+namespace {
+    const char *const piece_names = "IJLOSZT";
+
+    struct ReplayResult {
+        bool read;
+        tetriskl::FinesseReport report;
+    };
+
+    double percent(std::uint64_t part, std::uint64_t whole) {
+        return whole > 0 ? 100.0 * part / whole : 0.0;
+    }
+
+    void write_totals(std::ostream &output, const tetriskl::FinesseTotals &totals) {
+        output << totals.pieces << " pieces, " << totals.inputs << " inputs, " << totals.minimum << " needed, "
+               << totals.wasted << " wasted (" << percent(totals.wasted, totals.inputs) << "%), "
+               << totals.faults << " pieces with waste (" << percent(totals.faults, totals.pieces) << "%)";
+        if (totals.unreachable > 0)
+            output << ", " << totals.unreachable << " placed where the search can't reach";
+    }
+}
+
+int main(int argc, const char *argv[]) {
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " output replay..." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream output(argv[1]);
+    if (!output) {
+        std::cerr << "cannot open " << argv[1] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::size_t num_replays = argc - 2;
+    std::vector<ReplayResult> results(num_replays);
+    tetriskl::WorkStealingPool pool;
+    // each thread keeps its analyzer, and with it the searches it has already done, for all of its recordings
+    std::vector<tetriskl::FinesseAnalyzer> analyzers(pool.size());
+    auto start = std::chrono::steady_clock::now();
+    pool.run(num_replays, [&] (std::size_t task, std::size_t worker) {
+        std::ifstream input(argv[task + 2], std::ios::binary);
+        tetriskl::Replay replay;
+        // a recording that was cut off still has everything up to where it stops
+        results[task].read = tetriskl::read_replay(input, replay) || replay.end_frame > 0;
+        if (results[task].read)
+            results[task].report = analyzers[worker].analyze(replay);
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int status = EXIT_SUCCESS;
+    tetriskl::FinesseTotals totals{};
+    for (std::size_t i = 0; i < num_replays; i++) {
+        const char *path = argv[i + 2];
+        if (!results[i].read) {
+            std::cerr << path << ": not a replay" << std::endl;
+            status = EXIT_FAILURE;
+            continue;
+        }
+        const tetriskl::FinesseReport &report = results[i].report;
+        totals.add(report.totals);
+
+        output << path << ": ";
+        write_totals(output, report.totals);
+        output << "\n";
+        for (std::size_t p = 0; p < report.pieces.size(); p++) {
+            const tetriskl::PieceFinesse &piece = report.pieces[p];
+            output << "  " << p << " frame " << piece.spawn_frame
+                   << " " << piece_names[static_cast<int>(piece.piece.type())]
+                   << " rotation " << static_cast<int>(piece.piece.rotation())
+                   << " at " << piece.pos.x << "," << piece.pos.y
+                   << ": " << piece.inputs << " inputs";
+            if (piece.reachable)
+                output << ", " << piece.minimum << " needed, " << piece.wasted() << " wasted";
+            else
+                output << ", unreachable";
+            output << "\n";
+        }
+    }
+
+    std::uint64_t searches = 0;
+    std::uint64_t lookups = 0;
+    for (const tetriskl::FinesseAnalyzer &analyzer : analyzers) {
+        searches += analyzer.get_searches();
+        lookups += analyzer.get_lookups();
+    }
+    std::cout << num_replays << " replays: ";
+    write_totals(std::cout, totals);
+    std::cout << std::endl;
+    std::cout << searches << " searches for " << lookups << " pieces in " << seconds << " s on "
+              << pool.size() << " threads" << std::endl;
+    return status;
+}
@@ -10,37 +10,43 @@
 
 namespace tetriskl {
     const sf::Vector2u Tetris::cells_render_start{0, 10};
-    const sf::Time Tetris::evtloop_period = sf::seconds(1.f)/20.f;
+    const sf::Time Tetris::input_poll_period = sf::milliseconds(1);
+    const sf::Time Tetris::render_period = sf::seconds(1.f)/60.f;
     const sf::Time Tetris::flash_period = sf::seconds(0.1f);
     const unsigned int Tetris::flash_times = 5;
 
-    bool Tetris::new_piece() {
-        falling_piece = next_piece;
-        falling_piece_pos = sf::Vector2u(3, 9);
-        falling_piece_active = true;
-        next_piece = provider.next();
-        return cells.can_place(falling_piece_pos, falling_piece);
-    }
-
-    void Tetris::process_key(sf::RenderWindow &rw, sf::Keyboard::Key key) {
-        tick_timer.restart();
-        if (!game_over) {
+    void Tetris::process_key(sf::RenderWindow &rw, sf::Keyboard::Key key, sf::Time time) {
+        if (playback) {
+            process_playback_key(rw, key, time);
+        } else if (!sim_thread.get_snapshot().game_over) {
             switch (key) {
             case sf::Keyboard::Up:
-                falling_piece.rotate_ccw(cells, falling_piece_pos);
+            case sf::Keyboard::Z:
+                send_action(Action::ROTATE_CCW, time);
+                break;
+            case sf::Keyboard::X:
+                send_action(Action::ROTATE_CW, time);
+                break;
+            case sf::Keyboard::A:
+                send_action(Action::ROTATE_180, time);
                 break;
             case sf::Keyboard::Down:
-                move(sf::Vector2i(0, 1));
+                send_action(Action::SOFT_DROP, time);
                 break;
             case sf::Keyboard::Space:
-                while (move(sf::Vector2i(0, 1)));
-                tick(rw);
+                send_action(Action::HARD_DROP, time);
                 break;
             case sf::Keyboard::Left:
-                move(sf::Vector2i(-1, 0));
+                send_action(Action::MOVE_LEFT, time);
                 break;
             case sf::Keyboard::Right:
-                move(sf::Vector2i(1, 0));
+                send_action(Action::MOVE_RIGHT, time);
+                break;
+            case sf::Keyboard::B:
+                sim_thread.send(InputEvent{InputEvent::Type::AUTOPLAY, time, Action(), 0});
+                break;
+            case sf::Keyboard::H:
+                sim_thread.send(InputEvent{InputEvent::Type::HINTS, time, Action(), 0});
                 break;
             case sf::Keyboard::Escape:
                 pause(rw);
@@ -57,25 +63,57 @@ namespace tetriskl {
         }
     }
 
+    void Tetris::process_playback_key(sf::RenderWindow &rw, sf::Keyboard::Key key, sf::Time time) {
+        const std::int64_t seek_frames = static_cast<std::int64_t>(rules.frame_rate) * Tetris::seek_seconds;
+        switch (key) {
+        case sf::Keyboard::Left:
+            send_playback(InputEvent::Type::SEEK, -seek_frames, time);
+            break;
+        case sf::Keyboard::Right:
+            send_playback(InputEvent::Type::SEEK, seek_frames, time);
+            break;
+        case sf::Keyboard::Up:
+            send_playback(InputEvent::Type::PLAYBACK_SPEED, 1, time);
+            break;
+        case sf::Keyboard::Down:
+            send_playback(InputEvent::Type::PLAYBACK_SPEED, -1, time);
+            break;
+        case sf::Keyboard::Comma:
+            send_playback(InputEvent::Type::STEP, -1, time);
+            break;
+        case sf::Keyboard::Period:
+            send_playback(InputEvent::Type::STEP, 1, time);
+            break;
+        case sf::Keyboard::H:
+            sim_thread.send(InputEvent{InputEvent::Type::HINTS, time, Action(), 0});
+            break;
+        case sf::Keyboard::Space:
+            // from the start again
+            reset();
+            break;
+        case sf::Keyboard::Escape:
+            pause(rw);
+            break;
+        default:;
+        }
+    }
 
-    bool Tetris::move(sf::Vector2i dir) {
-        sf::Vector2i new_pos = sf::Vector2i(falling_piece_pos) + dir;
-        if (new_pos.x < 0 || new_pos.y < 0) return false;
-        sf::Vector2u unew_pos = sf::Vector2u(new_pos);
-        if (!cells.can_place(unew_pos, falling_piece)) return false;
-        falling_piece_pos = unew_pos;
-        return true;
+    void Tetris::send_playback(InputEvent::Type type, std::int64_t amount, sf::Time time) {
+        sim_thread.send(InputEvent{type, time, Action(), amount});
     }
 
-    void Tetris::reset() {
-        Tetris new_this;
-        if (this->font != nullptr)
-            new_this.set_font(*this->font);
+    void Tetris::send_action(Action action, sf::Time time) {
+        sim_thread.send(InputEvent{InputEvent::Type::ACTION, time, action, 0});
+    }
 
-        *this = std::move(new_this);
+    void Tetris::reset() {
+        sim_thread.send(InputEvent{InputEvent::Type::RESET, sim_thread.now(), Action(), 0});
     }
 
     void Tetris::pause(sf::RenderWindow &rw) {
+        // the game does not advance while the menu is open
+        sim_thread.send(InputEvent{InputEvent::Type::PAUSE, sim_thread.now(), Action(), 0});
+
         tetriskl::Menu menu;
         menu
             .set_font(*font)
@@ -84,6 +122,9 @@ namespace tetriskl {
             .add_menu_item(tetriskl::menu_action("QUIT GAME", [&] (auto& rw, auto& menu) { menu.close(); this->close(); }))
             .run(rw);
 
+        sim_thread.send(InputEvent{InputEvent::Type::RESUME, sim_thread.now(), Action(), 0});
+        next_render_time = sim_thread.now();
+        frame_timer.restart();
     }
 
     void Tetris::close() {
@@ -92,84 +133,87 @@ namespace tetriskl {
 
 
 
-    void Tetris::award_points(unsigned int lines_cleared) {
-        switch (lines_cleared) {
-        case 0: break;
-        case 1: score += 100; break;
-        case 2: score += 300; break;
-        case 3: score += 500; break;
-        case 4: score += 800; break;
-        default: score += 200 * lines_cleared;
-        }
+    const Simulation::Board& Tetris::displayed_board() const {
+        return (flash_board != nullptr) ? *flash_board : sim_thread.get_snapshot().board;
     }
 
-    void Tetris::clear_lines(sf::RenderWindow &rw) {
-        sf::Vector2u grid_size = cells.size();
-        std::size_t num_cleared_lines = 0;
-        unsigned int cleared_lines[decltype(Tetris::cells)::rows];
-        auto it = cells.begin();
-        for (std::size_t y = 0; y < grid_size.y; y++) {
-            bool line_filled = std::all_of(it[y].begin(), it[y].end(), [] (Cell c) { return c != Cell::N; });
-            if (line_filled)
-                cleared_lines[num_cleared_lines++] = y;
-        }
-
-        award_points(num_cleared_lines);
-        flash_lines(rw, cleared_lines, num_cleared_lines);
-
-        for (std::size_t i = 0; i < num_cleared_lines; i++) {
-            std::copy_backward(it, it + cleared_lines[i], it + cleared_lines[i] + 1);
-            it->fill(Cell::N);
-        }
+    void Tetris::flash_lines() {
+        // the cleared lines blink between the board before the clear and the same board without them
+        const FrameSnapshot &snapshot = sim_thread.get_snapshot();
+        flash_boards[1] = snapshot.pre_clear_board;
+        flash_boards[0] = flash_boards[1];
+        for (std::size_t i = 0; i < snapshot.num_cleared_lines; i++)
+            flash_boards[0].clear_row(snapshot.cleared_lines[i]);
+
+        animator.start(flash_period * static_cast<float>(flash_times),
+                       [this] (sf::Time elapsed) {
+                           sf::Int64 phase = elapsed.asMicroseconds() / flash_period.asMicroseconds();
+                           const Simulation::Board *board = &flash_boards[phase % 2 == 0 ? 0 : 1];
+                           if (board == flash_board) return;
+                           flash_board = board;
+                           stack_dirty = true;
+                       },
+                       [this] () {
+                           flash_board = nullptr;
+                           stack_dirty = true;
+                       });
     }
 
-    void Tetris::flash_lines(sf::RenderWindow &rw, unsigned int *lines, std::size_t num_lines) {
-        decltype(Tetris::cells) flash_buf = this->cells;
-        sf::Vector2u flash_buf_size = flash_buf.size();
-        for (std::size_t i = 0; i < num_lines; i++)
-            for (std::size_t x = 0; x < flash_buf_size.x; x++)
-                flash_buf[sf::Vector2u(x, lines[i])] = Cell::N;
-
-        for (unsigned int i = 0; i < flash_times; i++) {
-            std::swap(cells, flash_buf);
-            rw.draw(*this);
-            rw.display();
-            sf::sleep(flash_period);
+    void Tetris::present_snapshot() {
+        const FrameSnapshot &snapshot = sim_thread.get_snapshot();
+        if (snapshot.games != seen_games || snapshot.locks != seen_locks) {
+            // a running line flash shows the stack from before this piece locked
+            animator.finish_all();
+            stack_dirty = true;
         }
+        if (snapshot.games == seen_games && snapshot.line_clears != seen_line_clears)
+            flash_lines();
+        if (snapshot.score != displayed_score)
+            layout_score();
+
+        seen_games = snapshot.games;
+        seen_locks = snapshot.locks;
+        seen_line_clears = snapshot.line_clears;
     }
 
-    void Tetris::tick(sf::RenderWindow &rw) {
-        if (game_over) return;
-        bool successful_fall = this->move(sf::Vector2i(0, 1));
-        if (!successful_fall) {
-            // piece has fallen down completely
-            cells.place(falling_piece_pos, falling_piece);
-            falling_piece_active = false;
-            clear_lines(rw);
-            if (!new_piece()) game_over = true;
-        }
-    }
-
-    Tetris::Tetris()
-        : cells(),
-          tick_period(sf::seconds(0.5f)),
-          tick_timer(),
-          evtloop_timer(),
-          game_over(false),
-          score(0),
+    Tetris::Tetris(const Ruleset &rules, const std::string &replay_directory)
+        : Tetris(rules, replay_directory, nullptr) {}
+
+    Tetris::Tetris(const Replay &replay)
+        : Tetris(replay.header.rules, "", &replay) {}
+
+    Tetris::Tetris(const Ruleset &rules, const std::string &replay_directory, const Replay *replay)
+        : rules(rules),
+          hints(),
+          sim_thread(rules, replay_directory, replay),
+          seen_games(0),
+          seen_locks(0),
+          seen_line_clears(0),
+          displayed_score(0),
+          flash_boards(),
+          flash_board(nullptr),
+          next_render_time(),
+          frame_timer(),
+          animator(),
           closed(false),
-          provider() {
-        for (int i = 0; i < 2; i++)
-            new_piece();
+          playback(replay != nullptr),
+          font(nullptr),
+          stack_dirty(true) {
+        sim_thread.set_hint_engine(&hints);
     }
 
     void Tetris::set_font(const sf::Font &font) {
         this->font = &font;
+        layout_hud();
     }
 
     void Tetris::run(sf::RenderWindow &rw) {
+        hints.start();
+        sim_thread.start();
+        next_render_time = sim_thread.now();
+        frame_timer.restart();
         while (!this->closed && rw.isOpen()) {
-            evtloop_timer.restart();
+            sf::Time now = sim_thread.now();
 
             sf::Event ev;
             while (rw.pollEvent(ev)) {
@@ -178,21 +222,33 @@ namespace tetriskl {
                     pause(rw);
                     break;
                 case sf::Event::KeyPressed:
-                    process_key(rw, ev.key.code);
+                    process_key(rw, ev.key.code, now);
                     break;
                 default:;
                 }
             }
 
-            if (tick_timer.getElapsedTime() > tick_period) {
-                this->tick(rw);
-                tick_timer.restart();
-            }
+            if (sim_thread.update_snapshot())
+                present_snapshot();
+            hints.update_hint();
 
-            rw.draw(*this);
-            rw.display();
+            now = sim_thread.now();
+            if (now >= next_render_time) {
+                animator.advance(frame_timer.restart());
+                rw.draw(*this);
+                rw.display();
+
+                next_render_time += Tetris::render_period;
+                if (next_render_time <= now)
+                    next_render_time = now + Tetris::render_period;
+            }
 
-            sf::sleep(evtloop_period - evtloop_timer.getElapsedTime());
+            // sleep until the next frame, but keep sampling input often
+            sf::Time sleep_time = std::min(next_render_time - sim_thread.now(), Tetris::input_poll_period);
+            if (sleep_time > sf::Time::Zero)
+                sf::sleep(sleep_time);
         }
+        sim_thread.stop();
+        hints.stop();
     }
 }
@@ -1,31 +1,55 @@
 #ifndef GAME_H_
 #define GAME_H_
+#include "anim.h"
+#include "hint.h"
 #include "tetro.h"
+#include "bitgrid.h"
+#include "sim.h"
+#include "simthread.h"
+#include "tilebatch.h"
 
 #include <SFML/Graphics.hpp>
 #include <SFML/System.hpp>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
 namespace tetriskl {
     class Tetris: sf::Drawable {
     private:
-        StaticCellGrid<10, 30> cells;
+        Ruleset rules;
+        // declared before sim_thread, which sends it requests until it is destroyed
+        HintEngine hints;
+        SimulationThread sim_thread;
+        std::uint64_t seen_games;
+        std::uint64_t seen_locks;
+        std::uint64_t seen_line_clears;
+        unsigned int displayed_score;
+        std::array<Simulation::Board, 2> flash_boards;
+        const Simulation::Board *flash_board;
         const static sf::Vector2u cells_render_start;
-        Tetromino falling_piece;
-        Tetromino next_piece;
-        bool falling_piece_active;
-        sf::Vector2u falling_piece_pos;
-        sf::Time tick_period;
-        sf::Clock tick_timer;
-        sf::Clock evtloop_timer;
-        bool game_over;
-        unsigned int score;
+        sf::Time next_render_time;
+        sf::Clock frame_timer;
+        Animator animator;
         bool closed;
+        // a recorded game is shown, so the keys control the playback instead of the piece
+        bool playback;
 
-        const static sf::Time evtloop_period;
-        TetrominoProvider provider;
+        const static sf::Time input_poll_period;
+        const static sf::Time render_period;
+        constexpr static unsigned int seek_seconds = 10;
 
         const sf::Font *font;
+        mutable TileBatch tiles;
+        mutable TileBatch stack_tiles;
+        mutable std::unique_ptr<sf::RenderTexture> stack_texture;
+        mutable bool stack_dirty;
+        sf::Text score_text;
+        sf::RectangleShape score_text_box;
+        sf::Text game_over_text;
 
         const static sf::Time flash_period;
         const static unsigned int flash_times;
@@ -35,20 +59,30 @@ namespace tetriskl {
         constexpr static float game_over_text_size = 1.f;
         constexpr static float score_text_size = 1.f;
         constexpr static float vertical_score_padding = 0.5f;
+        constexpr static float stack_texture_margin = 0.5f;
 
-        bool new_piece();
-        void process_key(sf::RenderWindow &rw, sf::Keyboard::Key key);
-        bool move(sf::Vector2i dir);
+        void process_key(sf::RenderWindow &rw, sf::Keyboard::Key key, sf::Time time);
+        void process_playback_key(sf::RenderWindow &rw, sf::Keyboard::Key key, sf::Time time);
+        void send_playback(InputEvent::Type type, std::int64_t amount, sf::Time time);
+        void send_action(Action action, sf::Time time);
+        void present_snapshot();
         void reset();
         void pause(sf::RenderWindow &rw);
         void close();
-        void award_points(unsigned int lines_cleared);
-        void clear_lines(sf::RenderWindow &rw);
-        void flash_lines(sf::RenderWindow &rw, unsigned int *lines, std::size_t num_lines);
-        void tick(sf::RenderWindow &rw);
+        void layout_hud();
+        void layout_score();
+        const Simulation::Board& displayed_board() const;
+        void render_stack(sf::Vector2u visible_size) const;
+        void flash_lines();
         void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+        Tetris(const Ruleset &rules, const std::string &replay_directory, const Replay *replay);
     public:
-        Tetris();
+        // konstruktors Tetris(rules, replay_directory) sāk spēli, ierakstot katru spēli mapē replay_directory
+        explicit Tetris(const Ruleset &rules = default_ruleset, const std::string &replay_directory = "");
+        // konstruktors Tetris(replay) parāda ierakstīto spēli replay; bultiņas pa kreisi un pa labi to pārtin par 10
+        // sekundēm, bultiņas uz augšu un uz leju maina ātrumu, bet komats un punkts pārvieto par vienu kadru
+        explicit Tetris(const Replay &replay);
         void set_font(const sf::Font &font);
         void run(sf::RenderWindow &rw);
     };
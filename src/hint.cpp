@@ -0,0 +1,183 @@
+#include "hint.h"
+#include "zobrist.h"
+
+#include <algorithm>
+#include <SFML/System.hpp>
+
+namespace tetriskl {
+    const sf::Time HintEngine::idle_poll_period = sf::milliseconds(1);
+
+    // losing stays finite here, as the chance nodes average over the pieces the bag can still give
+    constexpr float lost_score = -1e9f;
+    constexpr std::uint8_t full_bag_mask = (1 << NUM_TETROMINOES) - 1;
+
+    HintEngine::HintEngine(const BotWeights &weights, unsigned int max_depth)
+        : weights(weights),
+          max_depth(std::min(std::max(max_depth, 1u), max_search_depth)),
+          requests(),
+          hints(),
+          current_request(0),
+          enabled(false),
+          running(false),
+          thread(),
+          generators(),
+          table(HintEngine::table_megabytes),
+          depth(0),
+          searched_request(0),
+          one_of_each_kind(true) {}
+
+    HintEngine::~HintEngine() {
+        stop();
+    }
+
+    void HintEngine::start() {
+        if (running.exchange(true)) return;
+        thread = std::thread([this] () { run(); });
+    }
+
+    void HintEngine::stop() {
+        running.store(false, std::memory_order_release);
+        cancel();
+        if (thread.joinable())
+            thread.join();
+    }
+
+    void HintEngine::set_enabled(bool enabled) {
+        this->enabled.store(enabled, std::memory_order_relaxed);
+        if (!enabled) cancel();
+    }
+
+    void HintEngine::analyze(const HintRequest &request) {
+        if (!is_enabled()) {
+            cancel();
+            return;
+        }
+        // the running search sees the new id and stops before the new request is even published
+        std::uint64_t id = current_request.load(std::memory_order_relaxed) + 1;
+        current_request.store(id, std::memory_order_relaxed);
+        HintRequest &buffer = requests.write_buffer();
+        buffer = request;
+        buffer.id = id;
+        requests.publish();
+    }
+
+    void HintEngine::cancel() {
+        current_request.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool HintEngine::update_hint() {
+        return hints.update();
+    }
+
+    const Hint& HintEngine::get_hint() const {
+        return hints.read_buffer();
+    }
+
+    bool HintEngine::cancelled() const {
+        return current_request.load(std::memory_order_relaxed) != searched_request;
+    }
+
+    void HintEngine::run() {
+        while (running.load(std::memory_order_acquire)) {
+            if (requests.update()) {
+                analyze_request(requests.read_buffer());
+                continue;
+            }
+            sf::sleep(HintEngine::idle_poll_period);
+        }
+    }
+
+    void HintEngine::analyze_request(const HintRequest &request) {
+        searched_request = request.id;
+        one_of_each_kind = request.randomizer == Randomizer::BAG_7 || request.randomizer == Randomizer::LEGACY_BAG_7;
+        table.new_search();
+        const std::uint64_t hash = Zobrist::board_key(request.rows);
+        const Tetromino known[2] = {request.piece, request.next_piece};
+        for (depth = 1; depth <= max_depth && !cancelled(); depth++) {
+            // the root is searched here rather than in search_piece, as it has to remember the best placement
+            const std::vector<Placement> &placements = generators[0].generate(request.rows, request.piece, request.pos);
+            const Placement *best = nullptr;
+            float best_score = lost_score;
+            for (const Placement &placement : placements) {
+                BoardRows after = request.rows;
+                std::uint64_t after_hash = hash;
+                unsigned int lines = apply_placement(after, placement, after_hash);
+                float score = search(after, after_hash, lines, 1, known, request.bag_mask);
+                if (cancelled()) return;
+                if (best == nullptr || score > best_score) {
+                    best = &placement;
+                    best_score = score;
+                }
+            }
+            if (best == nullptr) return;
+
+            Hint &hint = hints.write_buffer();
+            hint.valid = true;
+            hint.games = request.games;
+            hint.locks = request.locks;
+            hint.piece = best->piece;
+            hint.pos = best->pos;
+            hint.depth = depth;
+            hint.score = best_score;
+            hints.publish();
+        }
+    }
+
+    float HintEngine::search(const BoardRows &rows, std::uint64_t hash, unsigned int lines, std::size_t ply,
+                             const Tetromino *known, std::uint8_t bag_mask) {
+        if (ply == depth || cancelled())
+            return evaluate(rows, lines, weights);
+        if (ply < 2)
+            return search_piece(rows, hash, lines, ply, known[ply], Simulation::spawn_pos, known, bag_mask);
+
+        // Chance nodes are remembered without the lines cleared on the way, which only add to the score, so the
+        // next request finds the boards this one has searched one piece further. Besides the board, the score
+        // then only depends on the bag, the plies left and whether drawn kinds leave the bag.
+        const unsigned int remaining = depth - static_cast<unsigned int>(ply);
+        std::uint64_t node = bag_mask | std::uint64_t(remaining) << 8 | std::uint64_t(one_of_each_kind) << 12;
+        const std::uint64_t key = hash ^ splitmix64(node);
+        const float lines_score = weights.lines_cleared * lines;
+        TableEntry entry;
+        if (table.probe(key, entry))
+            return entry.score + lines_score;
+        float score = search_chance(rows, hash, 0, ply, known, bag_mask);
+        // a cancelled search returns early with a made-up score, which must not be remembered
+        if (!cancelled())
+            table.store(key, TableEntry{score, static_cast<std::uint8_t>(remaining), 0});
+        return score + lines_score;
+    }
+
+    float HintEngine::search_chance(const BoardRows &rows, std::uint64_t hash, unsigned int lines, std::size_t ply,
+                                    const Tetromino *known, std::uint8_t bag_mask) {
+        // Past the known pieces every piece left in the bag is taken as equally likely to come next. Only a bag
+        // of one of each kind loses the kind drawn; the other randomizers can still deal it again.
+        if (bag_mask == 0) bag_mask = full_bag_mask;
+        float total = 0.f;
+        unsigned int num_pieces = 0;
+        for (std::uint8_t pieces = bag_mask; pieces != 0; pieces &= pieces - 1) {
+            unsigned int kind = lowest_bit(pieces);
+            std::uint8_t rest = one_of_each_kind ? bag_mask & ~(1 << kind) : bag_mask;
+            total += search_piece(rows, hash, lines, ply, tetrominoes[kind], Simulation::spawn_pos, known, rest);
+            num_pieces++;
+        }
+        return total / num_pieces;
+    }
+
+    float HintEngine::search_piece(const BoardRows &rows, std::uint64_t hash, unsigned int lines, std::size_t ply,
+                                   const Tetromino &piece, sf::Vector2u pos, const Tetromino *known,
+                                   std::uint8_t bag_mask) {
+        // the boards of the last ply are only evaluated, so their hash isn't needed
+        const bool leaf = ply + 1 == depth;
+        float best_score = lost_score;
+        for (const Placement &placement : generators[ply].generate(rows, piece, pos)) {
+            BoardRows after = rows;
+            std::uint64_t after_hash = hash;
+            unsigned int placement_lines = leaf ? apply_placement(after, placement)
+                                                : apply_placement(after, placement, after_hash);
+            best_score = std::max(best_score, search(after, after_hash, lines + placement_lines, ply + 1, known,
+                                                     bag_mask));
+            if (cancelled()) break;
+        }
+        return best_score;
+    }
+}
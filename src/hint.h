@@ -0,0 +1,117 @@
+#ifndef HINT_H_
+#define HINT_H_
+#include "bot.h"
+#include "lockfree.h"
+#include "movegen.h"
+#include "tetro.h"
+#include "transtable.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <SFML/System.hpp>
+
+namespace tetriskl {
+    // struktūra HintRequest ir spēles stāvoklis tikko parādījušās gabala brīdī, ko analizēt
+    struct HintRequest {
+        BoardRows rows;
+        Tetromino piece;
+        Tetromino next_piece;
+        sf::Vector2u pos;
+        // gabali, kas vēl palikuši maisā pēc next_piece (sk. TetrominoProvider::bag_mask)
+        std::uint8_t bag_mask;
+        // how the pieces are dealt, which decides whether a drawn kind can still come from the same bag
+        Randomizer randomizer;
+        // spēle un nofiksēto gabalu skaits, pēc kuriem zīmēšana atpazīst, kuram gabalam padoms domāts
+        std::uint64_t games;
+        std::uint64_t locks;
+        // filled in by HintEngine::analyze
+        std::uint64_t id;
+    };
+
+    // struktūra Hint ir labākais līdz šim atrastais novietojums pieprasījuma gabalam
+    struct Hint {
+        bool valid;
+        std::uint64_t games;
+        std::uint64_t locks;
+        Tetromino piece;
+        sf::Vector2u pos;
+        // cik gabalus uz priekšu meklēšana paspēja apskatīt
+        unsigned int depth;
+        float score;
+    };
+
+    // Klase HintEngine savā pavedienā meklē labāko novietojumu katram jaunam gabalam ar pakāpenisku
+    // padziļināšanu: vispirms skatoties tikai uz pašu gabalu, tad arī uz nākamo, tad uz katru gabalu, kas vēl var
+    // iznākt no maisa, un tā tālāk. Nejaušo gabalu mezglu vērtējumi tiek atcerēti transpozīciju tabulā, tāpēc
+    // lauciņi, kas atkārtojas meklēšanā vai nākamajā pieprasījumā, nav jāvērtē vēlreiz. Pēc katra pabeigta
+    // dziļuma padoms tiek publicēts caur TripleBuffer, tāpēc zīmēšana to var paņemt jebkurā brīdī, negaidot.
+    // Pieprasījumus sūta tikai simulācijas pavediens, un katrs jauns pieprasījums vai cancel() nekavējoties
+    // pārtrauc iepriekšējo meklēšanu.
+    class HintEngine {
+    public:
+        constexpr static unsigned int max_search_depth = 4;
+        constexpr static std::size_t table_megabytes = 16;
+    private:
+        BotWeights weights;
+        unsigned int max_depth;
+        TripleBuffer<HintRequest> requests;
+        TripleBuffer<Hint> hints;
+        // the id of the request that should be searched now; anything else is cancelled
+        std::atomic<std::uint64_t> current_request;
+        std::atomic<bool> enabled;
+        std::atomic<bool> running;
+        std::thread thread;
+
+        // used only by the worker thread once it is started
+        std::array<MoveGenerator, max_search_depth> generators;
+        // the chance nodes' scores, which only depend on the weights and what the key holds
+        TranspositionTable table;
+        unsigned int depth;
+        std::uint64_t searched_request;
+        // true when a bag holds each kind once, so a drawn kind is gone until the next bag
+        bool one_of_each_kind;
+
+        const static sf::Time idle_poll_period;
+
+        bool cancelled() const;
+        void run();
+        void analyze_request(const HintRequest &request);
+        float search(const BoardRows &rows, std::uint64_t hash, unsigned int lines, std::size_t ply,
+                     const Tetromino *known, std::uint8_t bag_mask);
+        float search_chance(const BoardRows &rows, std::uint64_t hash, unsigned int lines, std::size_t ply,
+                            const Tetromino *known, std::uint8_t bag_mask);
+        float search_piece(const BoardRows &rows, std::uint64_t hash, unsigned int lines, std::size_t ply,
+                           const Tetromino &piece, sf::Vector2u pos, const Tetromino *known, std::uint8_t bag_mask);
+    public:
+        // konstruktors HintEngine(weights, max_depth) izveido meklētāju, kas vērtē lauciņus ar svariem weights un
+        // meklē ne dziļāk par max_depth gabaliem (ne vairāk par max_search_depth)
+        explicit HintEngine(const BotWeights &weights = default_bot_weights,
+                            unsigned int max_depth = max_search_depth);
+        ~HintEngine();
+        HintEngine(const HintEngine&) = delete;
+        HintEngine& operator=(const HintEngine&) = delete;
+
+        void start();
+        void stop();
+
+        // metodes set_enabled(enabled) un is_enabled() ieslēdz, izslēdz un pārbauda padomus; kamēr tie ir
+        // izslēgti, analyze() tikai pārtrauc meklēšanu
+        void set_enabled(bool enabled);
+        bool is_enabled() const { return enabled.load(std::memory_order_relaxed); }
+
+        // metode analyze(request) sāk meklēt padomu stāvoklim request; to drīkst izsaukt tikai simulācijas pavediens
+        void analyze(const HintRequest &request);
+        // metode cancel() pārtrauc pašreizējo meklēšanu; to drīkst izsaukt tikai simulācijas pavediens
+        void cancel();
+
+        // metode update_hint() paņem jaunāko publicēto padomu un atgriež true, ja tas ir jauns;
+        // to drīkst izsaukt tikai zīmēšanas pavediens
+        bool update_hint();
+        const Hint& get_hint() const;
+    };
+}
+
+#endif // HINT_H_
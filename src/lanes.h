@@ -0,0 +1,110 @@
+#ifndef LANES_H_
+#define LANES_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace tetriskl {
+    // LANE_WIDTH ir 32 bitu vērtību skaits vienā lane_vector: tik, cik ietilpst vienā mērķa procesora
+    // vektoru reģistrā, lai katra darbība ar lane_vector būtu viena instrukcija
+#if defined(__AVX512F__)
+    constexpr std::size_t LANE_WIDTH = 16;
+#elif defined(__AVX2__)
+    constexpr std::size_t LANE_WIDTH = 8;
+#else
+    constexpr std::size_t LANE_WIDTH = 4;
+#endif
+
+#if defined(__GNUC__)
+    // the compiler's own vector type, so the operators below are single SIMD instructions; comparisons give
+    // -1 in the lanes where they hold and 0 elsewhere
+    typedef std::int32_t lane_vector __attribute__((vector_size(LANE_WIDTH * sizeof(std::int32_t))));
+#else
+    // struktūra lane_vector ir tas pats bez kompilatora vektoru tipiem: darbības tiek veiktas pa vienai vērtībai
+    struct lane_vector {
+        std::int32_t lanes[LANE_WIDTH];
+
+        std::int32_t& operator[](std::size_t i) { return lanes[i]; }
+        std::int32_t operator[](std::size_t i) const { return lanes[i]; }
+    };
+
+    #define TETRISKL_LANE_OPERATOR(op, expr) \
+        inline lane_vector operator op(const lane_vector &a, const lane_vector &b) { \
+            lane_vector result; \
+            for (std::size_t i = 0; i < LANE_WIDTH; i++) result[i] = (expr); \
+            return result; \
+        }
+    TETRISKL_LANE_OPERATOR(&, a[i] & b[i])
+    TETRISKL_LANE_OPERATOR(|, a[i] | b[i])
+    TETRISKL_LANE_OPERATOR(+, a[i] + b[i])
+    TETRISKL_LANE_OPERATOR(-, a[i] - b[i])
+    TETRISKL_LANE_OPERATOR(==, a[i] == b[i] ? -1 : 0)
+    TETRISKL_LANE_OPERATOR(!=, a[i] != b[i] ? -1 : 0)
+    TETRISKL_LANE_OPERATOR(<=, a[i] <= b[i] ? -1 : 0)
+    #undef TETRISKL_LANE_OPERATOR
+
+    inline lane_vector operator~(const lane_vector &a) {
+        lane_vector result;
+        for (std::size_t i = 0; i < LANE_WIDTH; i++) result[i] = ~a[i];
+        return result;
+    }
+
+    #define TETRISKL_LANE_SHIFT(op) \
+        inline lane_vector operator op(const lane_vector &a, std::size_t shift) { \
+            lane_vector result; \
+            for (std::size_t i = 0; i < LANE_WIDTH; i++) result[i] = a[i] op shift; \
+            return result; \
+        }
+    TETRISKL_LANE_SHIFT(<<)
+    TETRISKL_LANE_SHIFT(>>)
+    #undef TETRISKL_LANE_SHIFT
+#endif
+
+    // funkcija lanes_load(p) nolasa LANE_WIDTH vērtības no p, kam nav jābūt izlīdzinātam
+    inline lane_vector lanes_load(const std::int32_t *p) {
+        lane_vector v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    // funkcija lanes_store(p, v) ieraksta v vērtības p
+    inline void lanes_store(std::int32_t *p, const lane_vector &v) {
+        std::memcpy(p, &v, sizeof(v));
+    }
+
+    // funkcija lanes_splat(x) atgriež vektoru, kura visās vērtībās ir x
+    inline lane_vector lanes_splat(std::int32_t x) {
+#if defined(__GNUC__)
+        // a scalar operand is broadcast by the compiler in one instruction, where filling the lanes one by one
+        // turns into a chain of shuffles
+        return lane_vector{} + x;
+#else
+        lane_vector v;
+        for (std::size_t i = 0; i < LANE_WIDTH; i++) v[i] = x;
+        return v;
+#endif
+    }
+
+    // funkcija lanes_select(mask, a, b) atgriež a vērtības tur, kur mask ir -1, un b vērtības tur, kur tā ir 0
+    inline lane_vector lanes_select(const lane_vector &mask, const lane_vector &a, const lane_vector &b) {
+        return (mask & a) | (~mask & b);
+    }
+
+    // funkcija lanes_min(a, b) atgriež mazāko no a un b katrā vērtībā
+    inline lane_vector lanes_min(const lane_vector &a, const lane_vector &b) {
+        return lanes_select(a <= b, a, b);
+    }
+
+    // funkcija lanes_any(mask) pārbauda, vai kāda maskas vērtība nav 0
+    inline bool lanes_any(const lane_vector &mask) {
+        // 64 bits at a time, which moves out of a vector register in one instruction instead of one per lane
+        std::uint64_t words[sizeof(lane_vector) / sizeof(std::uint64_t)];
+        std::memcpy(words, &mask, sizeof(words));
+        std::uint64_t any = 0;
+        for (std::uint64_t word : words) any |= word;
+        return any != 0;
+    }
+}
+
+#endif // LANES_H_
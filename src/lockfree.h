@@ -0,0 +1,88 @@
+#ifndef LOCKFREE_H_
+#define LOCKFREE_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace tetriskl {
+    // Klase TripleBuffer ļauj vienam rakstītājam nodot pilnas T vērtības vienam lasītājam bez slēdzenēm.
+    // Rakstītājs vienmēr raksta savā buferī, lasītājs vienmēr lasa savējā, un abi tikai apmainās ar vidējo.
+    template <typename T>
+    class TripleBuffer {
+    private:
+        constexpr static unsigned int index_mask = 3;
+        constexpr static unsigned int fresh_bit = 4;
+
+        std::array<T, 3> buffers;
+        // index of the middle buffer, with fresh_bit set when it holds data the reader hasn't taken yet
+        std::atomic<unsigned int> middle;
+        unsigned int back;
+        unsigned int front;
+    public:
+        TripleBuffer() : buffers(), middle(1), back(0), front(2) {}
+
+        // metode write_buffer() atgriež rakstītāja buferi; to drīkst izsaukt tikai rakstītājs
+        T& write_buffer() {
+            return buffers[back];
+        }
+
+        // metode publish() nodod rakstītāja buferi lasītājam; to drīkst izsaukt tikai rakstītājs
+        void publish() {
+            back = middle.exchange(back | fresh_bit, std::memory_order_acq_rel) & index_mask;
+        }
+
+        // metode update() paņem jaunāko publicēto vērtību, ja tāda ir; to drīkst izsaukt tikai lasītājs
+        bool update() {
+            if (!(middle.load(std::memory_order_relaxed) & fresh_bit)) return false;
+            front = middle.exchange(front, std::memory_order_acq_rel) & index_mask;
+            return true;
+        }
+
+        // metode read_buffer() atgriež lasītāja buferi; to drīkst izsaukt tikai lasītājs
+        const T& read_buffer() const {
+            return buffers[front];
+        }
+    };
+
+    // Klase SpscQueue ir fiksēta izmēra rinda bez slēdzenēm vienam rakstītājam un vienam lasītājam.
+    template <typename T, std::size_t Capacity>
+    class SpscQueue {
+    private:
+        static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+        constexpr static std::size_t cache_line = 64;
+
+        // Head and tail live on separate cache lines so the two threads don't keep stealing them. The queue is
+        // allocated with plain new inside larger objects, which only honours alignas beyond
+        // alignof(std::max_align_t) since C++17, so a cache line of padding separates them instead.
+        std::array<T, Capacity> items;
+        unsigned char head_padding[cache_line];
+        std::atomic<std::size_t> head;
+        unsigned char tail_padding[cache_line];
+        std::atomic<std::size_t> tail;
+        unsigned char end_padding[cache_line];
+    public:
+        SpscQueue() : items(), head_padding(), head(0), tail_padding(), tail(0), end_padding() {}
+
+        // metode push(item) ieliek item rindā un atgriež false, ja rinda ir pilna; to drīkst izsaukt tikai rakstītājs
+        bool push(const T &item) {
+            std::size_t t = tail.load(std::memory_order_relaxed);
+            if (t - head.load(std::memory_order_acquire) == Capacity) return false;
+            items[t & (Capacity - 1)] = item;
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        // metode pop(item) izņem nākamo elementu no rindas un atgriež false, ja rinda ir tukša;
+        // to drīkst izsaukt tikai lasītājs
+        bool pop(T &item) {
+            std::size_t h = head.load(std::memory_order_relaxed);
+            if (h == tail.load(std::memory_order_acquire)) return false;
+            item = items[h & (Capacity - 1)];
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+    };
+}
+
+#endif // LOCKFREE_H_
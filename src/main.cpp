@@ -1,20 +1,44 @@
 #include "game.h"
 #include "menu.h"
 #include "dirs.h"
+#include "replay.h"
 #include <SFML/Graphics.hpp>
+#include <fstream>
 #include <iostream>
 #include <cstdlib>
+#include <memory>
+
+// tetriskl [replay]
+//
+// Plays the game, recording every game into storage/replays, or plays back the recorded game replay.
 
 int main(int argc, const char *argv[]) {
-    sf::RenderWindow window(sf::VideoMode(640, 480), "tetriskl");
     tetriskl::ResourceLocator locator(argc, argv);
+    std::unique_ptr<tetriskl::Replay> replay;
+    if (argc > 1) {
+        std::ifstream input(argv[1], std::ios::binary);
+        replay.reset(new tetriskl::Replay());
+        if (!tetriskl::read_replay(input, *replay) && replay->end_frame == 0) {
+            std::cerr << "cannot read replay " << argv[1] << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    sf::RenderWindow window(sf::VideoMode(640, 480), "tetriskl");
     std::string font_path = locator.get_asset_path("font.ttf");
     sf::Font font;
     if (!font.loadFromFile(font_path)) {
         return EXIT_FAILURE;
     }
-    tetriskl::Tetris game;
-    game.set_font(font);
-    game.run(window);
+
+    std::unique_ptr<tetriskl::Tetris> game;
+    if (replay) {
+        game.reset(new tetriskl::Tetris(*replay));
+    } else {
+        tetriskl::make_directory(locator.get_storage_path(""));
+        game.reset(new tetriskl::Tetris(tetriskl::default_ruleset, locator.get_storage_path("replays")));
+    }
+    game->set_font(font);
+    game->run(window);
     return EXIT_SUCCESS;
 }
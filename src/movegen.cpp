@@ -0,0 +1,173 @@
+#include "movegen.h"
+
+#include <algorithm>
+#include <SFML/System.hpp>
+
+namespace tetriskl {
+    constexpr std::size_t MoveGenerator::num_states;
+    constexpr std::uint16_t MoveGenerator::no_state;
+    constexpr unsigned int MoveGenerator::open_margin;
+
+    MoveGenerator::MoveGenerator()
+        : fits(),
+          visited(),
+          landed(),
+          landing_rows(),
+          parents(),
+          parent_actions(),
+          queue(),
+          placement_keys(),
+          placements(),
+          kind(Cell::N),
+          symmetric(false) {}
+
+    void MoveGenerator::compute_fits(const BoardRows &rows) {
+        for (unsigned int rot = 0; rot < NUM_ROTATIONS; rot++) {
+            const TetrominoState &state = Tetromino::state_table.states[(int)kind][rot];
+            const row_type in_bounds = (row_type(1) << (Board::columns - state.width + 1)) - 1;
+            for (unsigned int y = 0; y < Board::rows; y++) {
+                row_type &row_fits = fits[rot * Board::rows + y];
+                if (y + state.height > Board::rows) {
+                    row_fits = 0;
+                    continue;
+                }
+                // a cell at (cx, cy) is blocked at x whenever the board has column x + cx of row y + cy taken
+                row_type blocked = 0;
+                for (const TilePoint &p : state.cells)
+                    blocked |= rows[y + p.y] >> p.x;
+                row_fits = ~blocked & in_bounds;
+            }
+        }
+    }
+
+    unsigned int MoveGenerator::landing_row(unsigned int rot, unsigned int y, unsigned int x) {
+        std::uint8_t &landing = landing_rows[state_index(rot, y, x)];
+        if (landing != 0xff) return landing;
+
+        // every state on the way down lands on the same row, so all of them are remembered
+        unsigned int bottom = y;
+        while (piece_fits(rot, x, bottom + 1) && landing_rows[state_index(rot, bottom + 1, x)] == 0xff)
+            bottom++;
+        if (piece_fits(rot, x, bottom + 1))
+            bottom = landing_rows[state_index(rot, bottom + 1, x)];
+        for (unsigned int row = y; row <= bottom; row++)
+            landing_rows[state_index(rot, row, x)] = bottom;
+        return bottom;
+    }
+
+    void MoveGenerator::add_placement(std::uint16_t source, unsigned int rot, unsigned int y, unsigned int x) {
+        if (!symmetric) {
+            placements.push_back(Placement{Tetromino(kind, (Rotation)rot), sf::Vector2u(x, y), source});
+            return;
+        }
+
+        // placements of symmetric pieces in different rotations can cover the same cells
+        std::uint64_t key = 0;
+        for (const TilePoint &p : Tetromino::state_table.states[(int)kind][rot].cells)
+            key = (key << 16) | state_index(0, y + p.y, x + p.x);
+        if (std::find(placement_keys.begin(), placement_keys.end(), key) != placement_keys.end()) return;
+
+        placement_keys.push_back(key);
+        placements.push_back(Placement{Tetromino(kind, (Rotation)rot), sf::Vector2u(x, y), source});
+    }
+
+    void MoveGenerator::visit(std::uint16_t from, Action action, unsigned int rot, unsigned int y, unsigned int x,
+                              std::size_t &queue_end) {
+        row_type &row_visited = visited[rot * Board::rows + y];
+        const row_type bit = row_type(1) << x;
+        if (row_visited & bit) return;
+        row_visited |= bit;
+
+        std::uint16_t state = state_index(rot, y, x);
+        parents[state] = from;
+        parent_actions[state] = action;
+        queue[queue_end++] = state;
+    }
+
+    void MoveGenerator::rotate(std::uint16_t from, Action action, unsigned int rot, unsigned int new_rot,
+                               unsigned int y, unsigned int x, std::size_t &queue_end) {
+        // the same kick tests as Tetromino::rotate_to, the first one that fits wins
+        const unsigned int num_kicks = Tetromino::state_table.num_kicks[(int)kind][rot][new_rot];
+        const KickOffset *kicks = Tetromino::state_table.kicks[(int)kind][rot][new_rot];
+        for (unsigned int i = 0; i < num_kicks; i++) {
+            int new_x = (int)x + kicks[i].x;
+            int new_y = (int)y + kicks[i].y;
+            if (piece_fits(new_rot, new_x, new_y)) {
+                visit(from, action, new_rot, new_y, new_x, queue_end);
+                return;
+            }
+        }
+    }
+
+    const std::vector<Placement>& MoveGenerator::generate(const BoardRows &rows, const Tetromino &piece,
+                                                          sf::Vector2u pos) {
+        placements.clear();
+        placement_keys.clear();
+        kind = piece.type();
+        if (kind == Cell::N) return placements;
+
+        compute_fits(rows);
+        symmetric = false;
+        for (unsigned int rot = 0; rot < NUM_ROTATIONS / 2; rot++) {
+            const TetrominoState &state = Tetromino::state_table.states[(int)kind][rot];
+            const TetrominoState &turned = Tetromino::state_table.states[(int)kind][rot + 2];
+            symmetric = symmetric || std::equal(state.rows, state.rows + TETROMINO_CELLS, turned.rows);
+        }
+        visited.fill(0);
+        landed.fill(0);
+        landing_rows.fill(0xff);
+        unsigned int start_rot = (unsigned int)piece.rotation();
+        if (!piece_fits(start_rot, pos.x, pos.y)) return placements;
+
+        const bool rotates = Tetromino::state_table.rotates[(int)kind];
+        unsigned int surface = 0;
+        while (surface < Board::rows && rows[surface] == 0) surface++;
+        std::size_t queue_begin = 0;
+        std::size_t queue_end = 0;
+        visit(MoveGenerator::no_state, Action::HARD_DROP, start_rot, pos.y, pos.x, queue_end);
+
+        // breadth first, so the first path found to any placement is also the shortest one
+        while (queue_begin < queue_end) {
+            std::uint16_t state = queue[queue_begin++];
+            unsigned int x = state % Board::columns;
+            unsigned int y = state / Board::columns % Board::rows;
+            unsigned int rot = state / (Board::columns * Board::rows);
+
+            // states above each other mostly land on the same spot, only the first one is a new placement
+            unsigned int landing = landing_row(rot, y, x);
+            row_type &row_landed = landed[rot * Board::rows + landing];
+            if (!((row_landed >> x) & 1)) {
+                row_landed |= row_type(1) << x;
+                add_placement(state, rot, landing, x);
+            }
+
+            if (landing > y)
+                visit(state, Action::SOFT_DROP, rot, y + 1, x, queue_end);
+
+            // Far above the stack every move or kick ends the same way as it would one row higher, and that one
+            // followed by a soft drop is already queued. A rotation shifts the piece by at most open_margin rows.
+            if (parent_actions[state] == Action::SOFT_DROP && y > MoveGenerator::open_margin
+                && y + TETROMINO_CELLS + MoveGenerator::open_margin <= surface)
+                continue;
+
+            if (piece_fits(rot, (int)x - 1, y))
+                visit(state, Action::MOVE_LEFT, rot, y, x - 1, queue_end);
+            if (piece_fits(rot, x + 1, y))
+                visit(state, Action::MOVE_RIGHT, rot, y, x + 1, queue_end);
+            if (rotates) {
+                rotate(state, Action::ROTATE_CCW, rot, (rot + 1) % NUM_ROTATIONS, y, x, queue_end);
+                rotate(state, Action::ROTATE_CW, rot, (rot + NUM_ROTATIONS - 1) % NUM_ROTATIONS, y, x, queue_end);
+                rotate(state, Action::ROTATE_180, rot, (rot + 2) % NUM_ROTATIONS, y, x, queue_end);
+            }
+        }
+        return placements;
+    }
+
+    void MoveGenerator::get_path(const Placement &placement, std::vector<Action> &path) const {
+        path.clear();
+        for (std::uint16_t state = placement.source; parents[state] != MoveGenerator::no_state; state = parents[state])
+            path.push_back(parent_actions[state]);
+        std::reverse(path.begin(), path.end());
+        path.push_back(Action::HARD_DROP);
+    }
+}
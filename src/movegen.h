@@ -0,0 +1,88 @@
+#ifndef MOVEGEN_H_
+#define MOVEGEN_H_
+#include "sim.h"
+#include "tetro.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <SFML/System.hpp>
+
+namespace tetriskl {
+    // tips BoardRows ir lauciņa rindu aizņemtības maskas bez šūnu krāsām
+    using BoardRows = std::array<Simulation::Board::row_type, Simulation::Board::rows>;
+
+    // struktūra Placement apraksta vienu gala novietojumu: gabalu tā rotācijā un pozīciju, kurā tas nofiksētos
+    struct Placement {
+        Tetromino piece;
+        sf::Vector2u pos;
+        // the search state the hard drop starts from, used to rebuild the input path
+        std::uint16_t source;
+    };
+
+    // Klase MoveGenerator atrod visus gala novietojumus, kuros gabals var nonākt no dotās pozīcijas ar
+    // Simulation darbībām (pārvietošanu, lēno krišanu un SRS pagriezieniem ar atsitieniem), ja gravitācija
+    // netraucē. Novietojumi ar vienādām aizņemtajām šūnām tiek saskaitīti vienreiz, un katram ir īsākais
+    // ievades ceļš, kas beidzas ar HARD_DROP. Meklēšana izmanto tikai bitu maskas un iepriekš rezervētas
+    // tabulas, tāpēc viens objekts jāizmanto atkārtoti.
+    class MoveGenerator {
+    public:
+        using Board = Simulation::Board;
+        constexpr static std::size_t num_states = NUM_ROTATIONS * Board::rows * Board::columns;
+        constexpr static std::uint16_t no_state = 0xffff;
+
+    private:
+        using row_type = Board::row_type;
+        constexpr static unsigned int open_margin = 4;
+
+        // for every rotation and row, the columns where the piece fits
+        std::array<row_type, NUM_ROTATIONS * Board::rows> fits;
+        std::array<row_type, NUM_ROTATIONS * Board::rows> visited;
+        std::array<row_type, NUM_ROTATIONS * Board::rows> landed;
+        std::array<std::uint8_t, num_states> landing_rows;
+        std::array<std::uint16_t, num_states> parents;
+        std::array<Action, num_states> parent_actions;
+        std::array<std::uint16_t, num_states> queue;
+        std::vector<std::uint64_t> placement_keys;
+        std::vector<Placement> placements;
+        Cell kind;
+        // whether a half turn can cover the same cells, which is the only way two placements can coincide
+        bool symmetric;
+
+        static std::uint16_t state_index(unsigned int rot, unsigned int y, unsigned int x) {
+            return (rot * Board::rows + y) * Board::columns + x;
+        }
+
+        bool piece_fits(unsigned int rot, int x, int y) const {
+            if (x < 0 || y < 0 || y >= (int)Board::rows) return false;
+            return (fits[rot * Board::rows + y] >> x) & 1;
+        }
+
+        void compute_fits(const BoardRows &rows);
+        unsigned int landing_row(unsigned int rot, unsigned int y, unsigned int x);
+        void visit(std::uint16_t from, Action action, unsigned int rot, unsigned int y, unsigned int x,
+                   std::size_t &queue_end);
+        void rotate(std::uint16_t from, Action action, unsigned int rot, unsigned int new_rot,
+                    unsigned int y, unsigned int x, std::size_t &queue_end);
+        void add_placement(std::uint16_t source, unsigned int rot, unsigned int y, unsigned int x);
+    public:
+        MoveGenerator();
+
+        // metode generate(board, piece, pos) atrod visus gabala piece gala novietojumus lauciņā board, sākot no
+        // pozīcijas pos. Rezultāts paliek derīgs līdz nākamajam generate izsaukumam.
+        const std::vector<Placement>& generate(const BoardRows &rows, const Tetromino &piece, sf::Vector2u pos);
+        const std::vector<Placement>& generate(const Board &board, const Tetromino &piece, sf::Vector2u pos) {
+            return generate(board.row_masks(), piece, pos);
+        }
+
+        // metode get_placements() atgriež pēdējā generate izsaukuma rezultātu
+        const std::vector<Placement>& get_placements() const { return placements; }
+
+        // metode get_path(placement, path) ieraksta path darbības, kas no sākuma pozīcijas noved gabalu
+        // novietojumā placement. Novietojumam jābūt no pēdējā generate izsaukuma.
+        void get_path(const Placement &placement, std::vector<Action> &path) const;
+    };
+}
+
+#endif // MOVEGEN_H_
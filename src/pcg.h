@@ -0,0 +1,97 @@
+#ifndef PCG_H_
+#define PCG_H_
+
+#include <cstdint>
+
+namespace tetriskl {
+    // Klase Pcg32 ir PCG-XSH-RR pseidonejaušo skaitļu ģenerators: 64 bitu lineāri kongruenta secība, kuras
+    // izvadi sajauc ar nobīdēm un rotāciju. Visu stāvokli veido divi skaitļi, tāpēc to ir lēti kopēt un
+    // saglabāt. Katrs nepāra pieaugums dod citu, neatkarīgu plūsmu, un secībā var pārlēkt uz priekšu
+    // logaritmiskā laikā, tāpēc paralēlas simulācijas var iegūt atšķirīgas, bet atkārtojamas secības.
+    class Pcg32 {
+    public:
+        using result_type = std::uint32_t;
+    private:
+        std::uint64_t state;
+        std::uint64_t increment;
+        constexpr static std::uint64_t multiplier = 6364136223846793005u;
+    public:
+        // konstruktors Pcg32(seed, stream) sāk plūsmas stream secību no sēklas seed
+        explicit Pcg32(std::uint64_t seed = 0, std::uint64_t stream = 0) : state(0), increment((stream << 1) | 1) {
+            next();
+            state += seed;
+            next();
+        }
+
+        // funkcija from_state(state, increment) atjauno ģeneratoru no get_state() un get_increment() vērtībām
+        static Pcg32 from_state(std::uint64_t state, std::uint64_t increment) {
+            Pcg32 rng;
+            rng.state = state;
+            rng.increment = increment | 1;
+            return rng;
+        }
+
+        std::uint64_t get_state() const { return state; }
+        std::uint64_t get_increment() const { return increment; }
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return 0xffffffffu; }
+
+        // metode next() atgriež nākamo 32 bitu skaitli
+        std::uint32_t next() {
+            std::uint64_t old = state;
+            state = old * multiplier + increment;
+            std::uint32_t shifted = static_cast<std::uint32_t>(((old >> 18) ^ old) >> 27);
+            unsigned int rotation = static_cast<unsigned int>(old >> 59);
+            return (shifted >> rotation) | (shifted << ((32 - rotation) & 31));
+        }
+
+        std::uint32_t operator()() { return next(); }
+
+        // metode bounded(bound) atgriež vienmērīgi sadalītu skaitli no 0 līdz bound - 1; bound nedrīkst būt 0
+        std::uint32_t bounded(std::uint32_t bound) {
+            // the low end of the range would come up slightly more often, so those outputs are drawn again
+            std::uint32_t threshold = (0u - bound) % bound;
+            for (;;) {
+                std::uint32_t value = next();
+                if (value >= threshold) return value % bound;
+            }
+        }
+
+        // metode advance(delta) pārlec pāri nākamajiem delta skaitļiem, neaprēķinot tos
+        void advance(std::uint64_t delta) {
+            // the step is an affine map, which composes with itself by squaring
+            std::uint64_t acc_multiplier = 1;
+            std::uint64_t acc_increment = 0;
+            std::uint64_t cur_multiplier = multiplier;
+            std::uint64_t cur_increment = increment;
+            for (; delta > 0; delta >>= 1) {
+                if (delta & 1) {
+                    acc_multiplier *= cur_multiplier;
+                    acc_increment = acc_increment * cur_multiplier + cur_increment;
+                }
+                cur_increment = (cur_multiplier + 1) * cur_increment;
+                cur_multiplier *= cur_multiplier;
+            }
+            state = acc_multiplier * state + acc_increment;
+        }
+
+        // metode split() atgriež jaunu ģeneratoru citā plūsmā, kuras sēklu un numuru nosaka šī ģeneratora
+        // nākamie skaitļi
+        Pcg32 split() {
+            // one call per statement, since the order of two calls in one expression is unspecified
+            std::uint64_t seed_high = next();
+            std::uint64_t seed_low = next();
+            std::uint64_t stream_high = next();
+            std::uint64_t stream_low = next();
+            return Pcg32(seed_high << 32 | seed_low, stream_high << 32 | stream_low);
+        }
+
+        bool operator==(const Pcg32 &other) const {
+            return state == other.state && increment == other.increment;
+        }
+        bool operator!=(const Pcg32 &other) const { return !(*this == other); }
+    };
+}
+
+#endif // PCG_H_
@@ -0,0 +1,88 @@
+#include "movegen.h"
+#include "sim.h"
+#include "tetro.h"
+#include "workpool.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// tetriskl-perft [depth] [seed] [threads]
+//
+// Counts every sequence of placements of the first depth pieces that TetrominoProvider(seed) gives, starting
+// from an empty board, like chess engines count positions to check and time their move generators. The
+// subtrees of the first placements are split between threads, and the counts of every depth are printed
+// together with the time it took.
+
+namespace {
+    using tetriskl::MoveGenerator;
+    using tetriskl::Placement;
+    using tetriskl::Simulation;
+    using tetriskl::Tetromino;
+
+    const char piece_names[] = "IJLOSZTN";
+
+    // the piece on the last level is only generated, never placed, as the count is all that is needed
+    void perft(const Simulation::Board &board, const std::vector<Tetromino> &queue, std::size_t depth,
+               std::vector<MoveGenerator> &generators, std::vector<std::uint64_t> &counts) {
+        const std::vector<Placement> &placements = generators[depth].generate(board, queue[depth],
+                                                                              Simulation::spawn_pos);
+        counts[depth] += placements.size();
+        if (depth + 1 == queue.size()) return;
+
+        for (const Placement &placement : placements) {
+            Simulation::Board next_board = board;
+            next_board.place(placement.pos, placement.piece);
+            next_board.remove_full_rows(placement.pos.y, placement.pos.y + placement.piece.state().height);
+            perft(next_board, queue, depth + 1, generators, counts);
+        }
+    }
+}
+
+int main(int argc, const char *argv[]) {
+    std::size_t depth = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 3;
+    std::uint32_t seed = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 0;
+    std::size_t num_threads = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 0;
+    if (depth == 0) {
+        std::cerr << "usage: " << argv[0] << " [depth] [seed] [threads]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    tetriskl::TetrominoProvider provider(seed);
+    std::vector<Tetromino> queue;
+    for (std::size_t i = 0; i < depth; i++)
+        queue.push_back(provider.next());
+
+    tetriskl::WorkStealingPool pool(num_threads);
+    std::vector<std::vector<MoveGenerator>> generators(pool.size(), std::vector<MoveGenerator>(depth));
+    std::vector<std::vector<std::uint64_t>> counts(pool.size(), std::vector<std::uint64_t>(depth, 0));
+
+    auto start = std::chrono::steady_clock::now();
+    Simulation::Board board;
+    MoveGenerator root_generator;
+    const std::vector<Placement> &roots = root_generator.generate(board, queue[0], Simulation::spawn_pos);
+    pool.run(roots.size(), [&] (std::size_t task, std::size_t worker) {
+        const Placement &root = roots[task];
+        Simulation::Board next_board = board;
+        next_board.place(root.pos, root.piece);
+        next_board.remove_full_rows(root.pos.y, root.pos.y + root.piece.state().height);
+        if (depth > 1)
+            perft(next_board, queue, 1, generators[worker], counts[worker]);
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::uint64_t total = 0;
+    for (std::size_t d = 0; d < depth; d++) {
+        std::uint64_t nodes = d == 0 ? roots.size() : 0;
+        for (const std::vector<std::uint64_t> &worker_counts : counts)
+            nodes += worker_counts[d];
+        total += nodes;
+        std::cout << "depth " << d + 1 << " (" << piece_names[(int)queue[d].type()] << "): "
+                  << nodes << std::endl;
+    }
+    std::cout << "nodes " << total << " in " << seconds << " s with " << pool.size() << " threads, "
+              << static_cast<std::uint64_t>(total / seconds) << " nodes/s" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -1,35 +1,91 @@
 #include "tetro.h"
 #include "game.h"
 #include "menu.h"
+#include <cmath>
+#include <cstdio>
 #include <iostream>
-#include <iomanip>
-#include <sstream>
 
 #include <SFML/Graphics.hpp>
 namespace tetriskl {
     const sf::Color background_color = sf::Color(0x141414ff);
     const sf::Color text_color = sf::Color(0xe6e6e6ff);
     const sf::Color inactive_text_color = sf::Color(0x9e9e9eff);
+    const sf::Uint8 ghost_piece_alpha = 0x50;
+    const sf::Color hint_color = sf::Color(0xffffff30);
 
-    void CellGrid::draw(sf::RenderTarget &target, sf::RenderStates states) const {
-        sf::Vector2u grid_size = this->size();
-        for (std::size_t y = 0; y < grid_size.y; y++) {
-            for (std::size_t x = 0; x < grid_size.x; x++) {
-                sf::RectangleShape rect;
-                Cell cell = (*this)[sf::Vector2u(x, y)];
-                rect.setSize(sf::Vector2f(1.f, 1.f));
-                rect.setPosition(x, y);
-                rect.setFillColor(cell_colors[(int)cell]);
-                rect.setOutlineThickness(0.03f);
-                rect.setOutlineColor(outline_color);
-                target.draw(rect, states);
-            }
-        }
+    array<sf::Color, NUM_CELLS> make_color_tbl() {
+        array<sf::Color, NUM_CELLS> retval;
+
+        retval[(int)Cell::I] = sf::Color(0x34dbebff);
+        retval[(int)Cell::J] = sf::Color(0x083673ff);
+        retval[(int)Cell::L] = sf::Color(0xeb8100ff);
+        retval[(int)Cell::O] = sf::Color(0xffdd00ff);
+        retval[(int)Cell::S] = sf::Color(0x098700ff);
+        retval[(int)Cell::Z] = sf::Color(0xcc2c00ff);
+        retval[(int)Cell::T] = sf::Color(0x969696ff);
+        retval[(int)Cell::N] = sf::Color(0x00000000);
+        return retval;
+    }
+
+    const sf::Color outline_color = sf::Color(0x6e6e6eff);
+    const array<sf::Color, NUM_CELLS> cell_colors = make_color_tbl();
+
+    TileBatch::TileBatch() : vertices(sf::Quads), tiles() {}
+
+    void TileBatch::resize(std::size_t num_tiles) {
+        if (num_tiles == tiles.size()) return;
+        Tile hidden{sf::Vector2f(), sf::Vector2f(), sf::Color::Transparent, false};
+        tiles.resize(num_tiles, hidden);
+        // new vertices all lie at the origin, so the new tiles have no area until set
+        vertices.resize(num_tiles * vertices_per_tile);
+    }
+
+    void TileBatch::set_quad(std::size_t vertex, sf::Vector2f top_left, sf::Vector2f bottom_right, sf::Color color) {
+        vertices[vertex + 0] = sf::Vertex(top_left, color);
+        vertices[vertex + 1] = sf::Vertex(sf::Vector2f(bottom_right.x, top_left.y), color);
+        vertices[vertex + 2] = sf::Vertex(bottom_right, color);
+        vertices[vertex + 3] = sf::Vertex(sf::Vector2f(top_left.x, bottom_right.y), color);
+    }
+
+    void TileBatch::set_tile(std::size_t i, sf::Vector2f pos, sf::Vector2f size, sf::Color fill) {
+        Tile &tile = tiles[i];
+        if (tile.visible && tile.pos == pos && tile.size == size && tile.fill == fill) return;
+        tile = Tile{pos, size, fill, true};
+
+        // the outline is drawn outside of the tile, like sf::RectangleShape does it
+        const float t = TileBatch::outline_thickness;
+        sf::Vector2f end = pos + size;
+        std::size_t vertex = i * vertices_per_tile;
+        set_quad(vertex, pos, end, fill);
+        set_quad(vertex + 4, pos - sf::Vector2f(t, t), sf::Vector2f(end.x + t, pos.y), outline_color);
+        set_quad(vertex + 8, sf::Vector2f(pos.x - t, end.y), end + sf::Vector2f(t, t), outline_color);
+        set_quad(vertex + 12, sf::Vector2f(pos.x - t, pos.y), sf::Vector2f(pos.x, end.y), outline_color);
+        set_quad(vertex + 16, sf::Vector2f(end.x, pos.y), sf::Vector2f(end.x + t, end.y), outline_color);
+    }
+
+    void TileBatch::hide_tile(std::size_t i) {
+        Tile &tile = tiles[i];
+        if (!tile.visible) return;
+        tile.visible = false;
+
+        std::size_t vertex = i * vertices_per_tile;
+        for (std::size_t v = vertex; v < vertex + vertices_per_tile; v++)
+            vertices[v] = sf::Vertex(sf::Vector2f(), sf::Color::Transparent);
+    }
+
+    void TileBatch::draw(sf::RenderTarget &target, sf::RenderStates states) const {
+        target.draw(vertices, states);
     }
 
     void Tetris::draw(sf::RenderTarget& target, sf::RenderStates states) const {
         target.clear(background_color);
-        const ConstGridView visible_cells(cells, Tetris::cells_render_start, cells.size());
+        const Simulation::Board &cells = displayed_board();
+        const auto visible_cells = const_grid_view(cells, Tetris::cells_render_start, cells.size());
+        const FrameSnapshot &snapshot = sim_thread.get_snapshot();
+        const bool game_over = snapshot.game_over;
+        const Tetromino &falling_piece = snapshot.falling_piece;
+        const Tetromino &next_piece = snapshot.next_piece;
+        const bool falling_piece_active = snapshot.falling_piece_active;
 
         sf::Vector2f view_size = target.getView().getSize();
         sf::Vector2f view_center = view_size/2.f;
@@ -42,81 +98,174 @@ namespace tetriskl {
         cstates.transform.translate(view_center - cells_drawcenter);
         cstates.transform *= cells_scale;
 
-        // draw main grid/game over display
+        // the locked stack is cached in a texture that is only redrawn when it changes
+        sf::Vector2u visible_size = visible_cells.size();
+        const sf::Vector2f unit_size(1.f, 1.f);
         if (!game_over) {
-            target.draw(visible_cells, cstates);
+            if (stack_dirty) render_stack(visible_size);
+
+            if (stack_texture) {
+                sf::RenderStates stack_states = cstates;
+                stack_states.transform.translate(-Tetris::stack_texture_margin, -Tetris::stack_texture_margin);
+                stack_states.transform.scale(1.f/Tetris::tile_scale, 1.f/Tetris::tile_scale);
+                target.draw(sf::Sprite(stack_texture->getTexture()), stack_states);
+            } else {
+                target.draw(stack_tiles, cstates);
+            }
+        }
+
+        // hint, ghost piece, falling piece and next piece display are drawn as one batch of tiles
+        tiles.resize(3 * TETROMINO_CELLS + 1 + TETROMINO_CELLS * TETROMINO_CELLS);
+        std::size_t tile = 0;
+
+        // the suggested placement, once the hint engine has one for this very piece
+        const Hint &hint = hints.get_hint();
+        bool show_hint = !game_over && falling_piece_active && hints.is_enabled() && hint.valid
+            && hint.games == snapshot.games && hint.locks == snapshot.locks;
+        sf::Vector2f hint_offset = sf::Vector2f(hint.pos) - sf::Vector2f(Tetris::cells_render_start);
+        for (const TilePoint &p : hint.piece.state().cells) {
+            if (show_hint)
+                tiles.set_tile(tile++, hint_offset + sf::Vector2f(p.x, p.y), unit_size, hint_color);
+            else
+                tiles.hide_tile(tile++);
+        }
+
+        // ghost piece where the falling piece would land, under the falling piece if they overlap
+        sf::Color ghost_color = cell_colors[(int)falling_piece.type()];
+        ghost_color.a = ghost_piece_alpha;
+        sf::Vector2f landing_offset = sf::Vector2f(snapshot.landing_pos) - sf::Vector2f(Tetris::cells_render_start);
+        for (const TilePoint &p : falling_piece.state().cells) {
+            if (!game_over && falling_piece_active)
+                tiles.set_tile(tile++, landing_offset + sf::Vector2f(p.x, p.y), unit_size, ghost_color);
+            else
+                tiles.hide_tile(tile++);
+        }
 
-            // draw falling piece
-            if (falling_piece_active) {
-                sf::RenderStates falling_piece_states = cstates;
-                falling_piece_states.transform.translate(sf::Vector2f(falling_piece_pos)
-                                                         - sf::Vector2f(Tetris::cells_render_start));
+        // falling piece, only its occupied cells as the grid is already drawn under the rest
+        sf::Vector2f falling_piece_offset = sf::Vector2f(snapshot.falling_piece_pos)
+            - sf::Vector2f(Tetris::cells_render_start);
+        for (const TilePoint &p : falling_piece.state().cells) {
+            if (!game_over && falling_piece_active)
+                tiles.set_tile(tile++, falling_piece_offset + sf::Vector2f(p.x, p.y), unit_size,
+                               cell_colors[(int)falling_piece.type()]);
+            else
+                tiles.hide_tile(tile++);
+        }
 
-                target.draw(falling_piece, falling_piece_states);
+        // the box around the next piece
+        sf::Vector2f next_piece_box_pos(visible_size.x, 0);
+        sf::Vector2f next_piece_box_size(Tetris::next_piece_box_size, Tetris::next_piece_box_size);
+        tiles.set_tile(tile++, next_piece_box_pos, next_piece_box_size, sf::Color::Transparent);
+
+        // the next piece itself
+        sf::Vector2u next_piece_size = next_piece.size();
+        sf::Vector2f next_piece_pos = next_piece_box_pos + next_piece_box_size/2.f - sf::Vector2f(next_piece_size)/2.f;
+        for (std::size_t y = 0; y < TETROMINO_CELLS; y++) {
+            for (std::size_t x = 0; x < TETROMINO_CELLS; x++) {
+                if (x < next_piece_size.x && y < next_piece_size.y) {
+                    Cell cell = next_piece[sf::Vector2u(x, y)];
+                    tiles.set_tile(tile++, next_piece_pos + sf::Vector2f(x, y), unit_size, cell_colors[(int)cell]);
+                } else {
+                    tiles.hide_tile(tile++);
+                }
             }
-        } else {
-            sf::Text game_over_text("Game over!", *this->font, Tetris::text_render_size);
-            game_over_text.setFillColor(text_color);
-            sf::FloatRect game_over_text_local_bounds = game_over_text.getLocalBounds();
-            float game_over_text_scale = Tetris::game_over_text_size/game_over_text_local_bounds.height;
-            game_over_text.setScale(game_over_text_scale, game_over_text_scale);
-            sf::FloatRect game_over_text_bounds = game_over_text.getGlobalBounds();
-            sf::Vector2f game_over_text_pos = sf::Vector2f(visible_cells.size())/2.f
-                - sf::Vector2f(game_over_text_bounds.width, game_over_text_bounds.height)/2.f
-                - sf::Vector2f(game_over_text_bounds.left, game_over_text_bounds.height);
-            game_over_text.setPosition(game_over_text_pos);
+        }
+
+        target.draw(tiles, cstates);
+
+        // game over display
+        if (game_over)
             target.draw(game_over_text, cstates);
+
+        // draw score display
+        sf::RenderStates score_display_states = cstates;
+        score_display_states.transform.translate(next_piece_box_pos + sf::Vector2f(0, next_piece_box_size.y));
+        target.draw(score_text_box, score_display_states);
+        target.draw(score_text, score_display_states);
+    }
+
+    void Tetris::render_stack(sf::Vector2u visible_size) const {
+        const Simulation::Board &cells = displayed_board();
+        const auto visible_cells = const_grid_view(cells, Tetris::cells_render_start, cells.size());
+        stack_tiles.resize(visible_size.x * visible_size.y);
+        std::size_t tile = 0;
+        for (std::size_t y = 0; y < visible_size.y; y++) {
+            for (std::size_t x = 0; x < visible_size.x; x++) {
+                Cell cell = visible_cells[sf::Vector2u(x, y)];
+                stack_tiles.set_tile(tile++, sf::Vector2f(x, y), sf::Vector2f(1.f, 1.f), cell_colors[(int)cell]);
+            }
         }
+        stack_dirty = false;
 
-        // draw next piece display
+        if (!stack_texture) {
+            sf::Vector2f texture_size = (sf::Vector2f(visible_size)
+                                         + 2.f * sf::Vector2f(Tetris::stack_texture_margin, Tetris::stack_texture_margin))
+                * Tetris::tile_scale;
+            stack_texture.reset(new sf::RenderTexture());
+            // without a texture the stack tiles are drawn directly every frame
+            if (!stack_texture->create(std::ceil(texture_size.x), std::ceil(texture_size.y))) {
+                stack_texture.reset();
+                return;
+            }
+        }
 
-        // the box around the piece
-        sf::RenderStates next_piece_box_states = cstates;
-        next_piece_box_states.transform.translate(sf::Vector2f(visible_cells.size().x, 0));
-        sf::RectangleShape next_piece_box;
-        next_piece_box.setSize(sf::Vector2f(Tetris::next_piece_box_size, Tetris::next_piece_box_size));
-        next_piece_box.setOutlineColor(outline_color);
-        next_piece_box.setOutlineThickness(0.03f);
-        next_piece_box.setFillColor(sf::Color::Transparent);
-        target.draw(next_piece_box, next_piece_box_states);
+        sf::RenderStates states;
+        states.transform.scale(Tetris::tile_scale, Tetris::tile_scale);
+        states.transform.translate(Tetris::stack_texture_margin, Tetris::stack_texture_margin);
+        stack_texture->clear(sf::Color::Transparent);
+        stack_texture->draw(stack_tiles, states);
+        stack_texture->display();
+    }
 
-        // the piece itself
-        sf::RenderStates next_piece_states = next_piece_box_states;
-        next_piece_states.transform.translate(next_piece_box.getSize()/2.f - sf::Vector2f(next_piece.size())/2.f);
-        target.draw(next_piece, next_piece_states);
+    void Tetris::layout_hud() {
+        if (this->font == nullptr) return;
 
-        // draw score display
-        sf::RenderStates score_display_states = next_piece_box_states;
-        score_display_states.transform.translate(0, next_piece_box.getSize().y);
+        // make sure the digits are rasterized before the score first changes
+        for (char digit = '0'; digit <= '9'; digit++)
+            this->font->getGlyph(digit, Tetris::text_render_size, false);
 
-        // convert score to string
-        std::stringstream score_string;
-        score_string << std::setw(6) << std::setfill('0') << score;
+        const sf::Vector2u visible_size = sf::Vector2u(Simulation::Board::columns, Simulation::Board::rows)
+            - Tetris::cells_render_start;
+        game_over_text = sf::Text("Game over!", *this->font, Tetris::text_render_size);
+        game_over_text.setFillColor(text_color);
+        sf::FloatRect game_over_text_local_bounds = game_over_text.getLocalBounds();
+        float game_over_text_scale = Tetris::game_over_text_size/game_over_text_local_bounds.height;
+        game_over_text.setScale(game_over_text_scale, game_over_text_scale);
+        sf::FloatRect game_over_text_bounds = game_over_text.getGlobalBounds();
+        sf::Vector2f game_over_text_pos = sf::Vector2f(visible_size)/2.f
+            - sf::Vector2f(game_over_text_bounds.width, game_over_text_bounds.height)/2.f
+            - sf::Vector2f(game_over_text_bounds.left, game_over_text_bounds.height);
+        game_over_text.setPosition(game_over_text_pos);
 
-        // create sf::Text object
-        sf::Text score_text(score_string.str(), *this->font, Tetris::text_render_size);
+        score_text = sf::Text("", *this->font, Tetris::text_render_size);
         score_text.setFillColor(text_color);
+        score_text_box.setOutlineColor(outline_color);
+        score_text_box.setOutlineThickness(0.03f);
+        score_text_box.setFillColor(sf::Color::Transparent);
+        layout_score();
+    }
+
+    void Tetris::layout_score() {
+        if (this->font == nullptr) return;
+
+        // convert score to string
+        displayed_score = sim_thread.get_snapshot().score;
+        char score_string[16];
+        std::snprintf(score_string, sizeof(score_string), "%06u", displayed_score);
+
+        score_text.setString(score_string);
+        score_text.setPosition(0.f, 0.f);
+        score_text.setScale(1.f, 1.f);
         sf::FloatRect score_text_local_bounds = score_text.getLocalBounds();
         float score_text_scale = Tetris::score_text_size/score_text_local_bounds.height;
         score_text.setScale(score_text_scale, score_text_scale);
         sf::FloatRect score_text_bounds = score_text.getGlobalBounds();
 
-        // create box
-        sf::RectangleShape score_text_box;
         score_text_box.setSize(sf::Vector2f(Tetris::next_piece_box_size,
                                             score_text_bounds.height + 2.f * vertical_score_padding));
-        score_text_box.setOutlineColor(outline_color);
-        score_text_box.setOutlineThickness(0.03f);
-        score_text_box.setFillColor(sf::Color::Transparent);
-
-        // draw box
-        target.draw(score_text_box, score_display_states);
-
-        // draw score
         score_text.setPosition(score_text_box.getSize()/2.f
                                - sf::Vector2f(score_text_bounds.width, score_text_bounds.height)/2.f
                                - sf::Vector2f(score_text_bounds.left, score_text_bounds.top));
-        target.draw(score_text, score_display_states);
     }
 
     sf::FloatRect MenuAction::get_bounds() const {
@@ -0,0 +1,335 @@
+#include "replay.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace tetriskl {
+    constexpr char replay_magic[4] = {'T', 'K', 'L', 'R'};
+    constexpr unsigned int action_bits = 3;
+    // the code after the last action, followed by the kind of record since version 2
+    constexpr std::uint64_t escape_code = (1 << action_bits) - 1;
+    constexpr std::uint64_t end_record = 0;
+    constexpr std::uint64_t checkpoint_record = 1;
+    constexpr unsigned int cell_bits = 3;
+    constexpr unsigned int rotation_shift = 3;
+
+    using Board = Simulation::Board;
+
+    // packs values of any width up to 32 bits one after another, the first one in the lowest bits
+    class BitWriter {
+    private:
+        std::vector<std::uint8_t> &bytes;
+        std::uint64_t buffer;
+        unsigned int count;
+    public:
+        explicit BitWriter(std::vector<std::uint8_t> &bytes) : bytes(bytes), buffer(0), count(0) {}
+
+        void put(std::uint32_t value, unsigned int bits) {
+            buffer |= static_cast<std::uint64_t>(value) << count;
+            count += bits;
+            for (; count >= 8; count -= 8, buffer >>= 8)
+                bytes.push_back(static_cast<std::uint8_t>(buffer));
+        }
+
+        void finish() {
+            if (count > 0) bytes.push_back(static_cast<std::uint8_t>(buffer));
+            buffer = 0;
+            count = 0;
+        }
+    };
+
+    class BitReader {
+    private:
+        std::istream &input;
+        std::uint64_t buffer;
+        unsigned int count;
+    public:
+        explicit BitReader(std::istream &input) : input(input), buffer(0), count(0) {}
+
+        bool get(std::uint32_t &value, unsigned int bits) {
+            while (count < bits) {
+                int byte = input.get();
+                if (byte == std::istream::traits_type::eof()) return false;
+                buffer |= static_cast<std::uint64_t>(byte) << count;
+                count += 8;
+            }
+            value = static_cast<std::uint32_t>(buffer & ((std::uint64_t(1) << bits) - 1));
+            buffer >>= bits;
+            count -= bits;
+            return true;
+        }
+    };
+
+    ReplayEncoder::ReplayEncoder() : bytes(), last_frame(0) {}
+
+    void ReplayEncoder::put_varint(std::uint64_t value) {
+        // seven bits per byte, the high bit set on every byte but the last
+        while (value >= 0x80) {
+            bytes.push_back(static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back(static_cast<std::uint8_t>(value));
+    }
+
+    void ReplayEncoder::begin(const ReplayHeader &header) {
+        last_frame = 0;
+        bytes.insert(bytes.end(), replay_magic, replay_magic + sizeof(replay_magic));
+        put_varint(header.version);
+        put_varint(header.seed);
+        put_varint(header.rules.frame_rate);
+        put_varint(header.rules.lines_per_level);
+        put_varint(header.rules.lock_delay_frames);
+        for (const Gravity &gravity : header.rules.gravity) {
+            put_varint(gravity.rows);
+            put_varint(gravity.frames);
+        }
+        put_varint(static_cast<std::uint64_t>(header.rules.randomizer));
+    }
+
+    void ReplayEncoder::add(std::uint64_t frame, Action action) {
+        put_varint((frame - last_frame) << action_bits | static_cast<std::uint64_t>(action));
+        last_frame = frame;
+    }
+
+    void ReplayEncoder::put_piece(const Tetromino &piece) {
+        put_varint(static_cast<std::uint64_t>(piece.type())
+                   | static_cast<std::uint64_t>(piece.rotation()) << rotation_shift);
+    }
+
+    void ReplayEncoder::add_checkpoint(const Simulation::Checkpoint &state) {
+        put_varint((state.frame - last_frame) << action_bits | escape_code);
+        put_varint(checkpoint_record);
+        last_frame = state.frame;
+
+        put_varint((state.falling_piece_active ? 1 : 0) | (state.game_over ? 2 : 0));
+        put_varint(state.score);
+        put_varint(state.lines);
+        put_varint(state.gravity_counter);
+        put_varint(state.lock_counter);
+        put_varint(state.provider.rng_state);
+        put_varint(state.provider.rng_increment);
+        put_varint(state.provider.size);
+        put_varint(state.provider.next);
+        put_piece(state.falling_piece);
+        put_piece(state.next_piece);
+        put_varint(state.falling_piece_pos.x);
+        put_varint(state.falling_piece_pos.y);
+
+        // the bag comes first, then the board without the empty rows on top, every row as its mask followed by
+        // the kind of each filled cell
+        std::size_t top = 0;
+        while (top < Board::rows && state.board.row(top) == 0) top++;
+        put_varint(top);
+        BitWriter bits(bytes);
+        for (std::size_t k = 0; k < state.provider.size; k++)
+            bits.put(static_cast<std::uint32_t>(state.provider.pool[k]), cell_bits);
+        for (std::size_t y = top; y < Board::rows; y++) {
+            Board::row_type mask = state.board.row(y);
+            bits.put(mask, Board::columns);
+            for (; mask != 0; mask &= mask - 1)
+                bits.put(static_cast<std::uint32_t>(state.board[sf::Vector2u(lowest_bit(mask), y)]), cell_bits);
+        }
+        bits.finish();
+    }
+
+    void ReplayEncoder::end(std::uint64_t frame) {
+        put_varint((frame - last_frame) << action_bits | escape_code);
+        put_varint(end_record);
+        last_frame = frame;
+    }
+
+    static bool get_varint(std::istream &input, std::uint64_t &value) {
+        value = 0;
+        for (unsigned int shift = 0; shift < 64; shift += 7) {
+            int byte = input.get();
+            if (byte == std::istream::traits_type::eof()) return false;
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    template <typename T>
+    static bool get_field(std::istream &input, T &field) {
+        std::uint64_t value;
+        if (!get_varint(input, value)) return false;
+        field = static_cast<T>(value);
+        return field == value;
+    }
+
+    static bool read_piece(std::istream &input, Tetromino &piece) {
+        std::uint64_t value;
+        if (!get_varint(input, value)) return false;
+        std::uint64_t kind = value & ((1 << rotation_shift) - 1);
+        std::uint64_t rotation = value >> rotation_shift;
+        if (kind > static_cast<std::uint64_t>(Cell::N) || rotation >= NUM_ROTATIONS) return false;
+        piece = Tetromino(static_cast<Cell>(kind), static_cast<Rotation>(rotation));
+        return true;
+    }
+
+    // deals the pieces of a version 2 recording up to each of its checkpoints, which come in order
+    struct CheckpointDealer {
+        TetrominoProvider provider;
+        std::uint64_t dealt;
+    };
+
+    static bool read_checkpoint(std::istream &input, const ReplayHeader &header, std::size_t num_events,
+                                CheckpointDealer &dealer, Simulation::Checkpoint &state) {
+        std::uint64_t flags;
+        if (!get_varint(input, flags)) return false;
+        state.falling_piece_active = flags & 1;
+        state.game_over = flags & 2;
+        if (!(get_field(input, state.score) && get_field(input, state.lines)
+              && get_field(input, state.gravity_counter) && get_field(input, state.lock_counter)))
+            return false;
+
+        TetrominoProvider::State &provider = state.provider;
+        provider.pool.fill(Cell::Z);
+        if (header.version < 3) {
+            // Only the count of dealt pieces was stored, and dealing them gives the rest. Every piece but the
+            // first two follows a lock, which takes a frame or a hard drop, so a larger count is corrupt.
+            std::uint64_t pieces_dealt;
+            if (!get_varint(input, pieces_dealt) || pieces_dealt > state.frame + num_events + 2) return false;
+            if (pieces_dealt < dealer.dealt)
+                dealer = CheckpointDealer{TetrominoProvider(header.seed, header.rules.randomizer), 0};
+            for (; dealer.dealt < pieces_dealt; dealer.dealt++)
+                dealer.provider.next();
+            provider = dealer.provider.get_state();
+        } else if (!(get_varint(input, provider.rng_state) && get_varint(input, provider.rng_increment)
+                     && get_field(input, provider.size) && get_field(input, provider.next)
+                     && provider.size <= TetrominoProvider::max_pool && provider.next <= provider.size)) {
+            return false;
+        }
+
+        std::size_t top;
+        if (!(read_piece(input, state.falling_piece) && read_piece(input, state.next_piece)
+              && get_field(input, state.falling_piece_pos.x) && get_field(input, state.falling_piece_pos.y)
+              && get_field(input, top)))
+            return false;
+        if (state.falling_piece_pos.x >= Board::columns || state.falling_piece_pos.y >= Board::rows || top > Board::rows)
+            return false;
+
+        BitReader bits(input);
+        if (header.version >= 3) {
+            for (std::size_t k = 0; k < provider.size; k++) {
+                std::uint32_t kind;
+                if (!bits.get(kind, cell_bits) || kind >= NUM_TETROMINOES) return false;
+                provider.pool[k] = static_cast<Cell>(kind);
+            }
+        }
+        state.board = Board();
+        for (std::size_t y = top; y < Board::rows; y++) {
+            std::uint32_t mask;
+            if (!bits.get(mask, Board::columns)) return false;
+            for (; mask != 0; mask &= mask - 1) {
+                std::uint32_t kind;
+                if (!bits.get(kind, cell_bits) || kind >= NUM_TETROMINOES) return false;
+                state.board.set(sf::Vector2u(lowest_bit(mask), y), static_cast<Cell>(kind));
+            }
+        }
+        return true;
+    }
+
+    bool read_replay(std::istream &input, Replay &replay) {
+        replay.events.clear();
+        replay.checkpoints.clear();
+        replay.end_frame = 0;
+
+        char magic[sizeof(replay_magic)];
+        if (!input.read(magic, sizeof(magic)) || std::memcmp(magic, replay_magic, sizeof(magic)) != 0)
+            return false;
+        ReplayHeader &header = replay.header;
+        if (!get_field(input, header.version) || header.version == 0 || header.version > REPLAY_VERSION)
+            return false;
+        bool header_read = get_field(input, header.seed)
+            && get_field(input, header.rules.frame_rate)
+            && get_field(input, header.rules.lines_per_level)
+            && get_field(input, header.rules.lock_delay_frames);
+        for (Gravity &gravity : header.rules.gravity)
+            header_read = header_read && get_field(input, gravity.rows) && get_field(input, gravity.frames);
+        // before version 3 every game used the 7-bag on std::mt19937
+        header.rules.randomizer = Randomizer::LEGACY_BAG_7;
+        if (header.version >= 3) {
+            std::uint64_t randomizer = 0;
+            header_read = header_read && get_varint(input, randomizer) && randomizer < NUM_RANDOMIZERS;
+            if (header_read) header.rules.randomizer = static_cast<Randomizer>(randomizer);
+        }
+        // a frame rate of 0 would make playback never advance, and neither could have been recorded
+        if (!header_read || header.rules.frame_rate == 0 || header.rules.lines_per_level == 0) return false;
+
+        CheckpointDealer dealer{TetrominoProvider(header.seed, header.rules.randomizer), 0};
+        std::uint64_t frame = 0;
+        std::uint64_t code;
+        while (get_varint(input, code)) {
+            frame += code >> action_bits;
+            code &= escape_code;
+            if (code != escape_code) {
+                replay.events.push_back(ReplayEvent{frame, static_cast<Action>(code)});
+                continue;
+            }
+
+            // version 1 only had the end behind the escape code
+            std::uint64_t record = end_record;
+            if (header.version > 1 && !get_varint(input, record)) break;
+            if (record == end_record) {
+                replay.end_frame = frame;
+                return true;
+            }
+            if (record != checkpoint_record) return false;
+            ReplayCheckpoint checkpoint;
+            checkpoint.state.frame = frame;
+            checkpoint.next_event = replay.events.size();
+            if (!read_checkpoint(input, header, replay.events.size(), dealer, checkpoint.state)) break;
+            replay.checkpoints.push_back(checkpoint);
+        }
+        // cut off before the end marker, e.g. when the game crashed, but everything up to there still plays
+        replay.end_frame = replay.events.empty() ? 0 : frame + 1;
+        return false;
+    }
+
+    ReplayInput::ReplayInput(const Replay &replay) : replay(&replay), next_event(0) {}
+
+    void ReplayInput::actions_at(std::uint64_t frame, std::vector<Action> &actions) {
+        const std::vector<ReplayEvent> &events = replay->events;
+        while (next_event < events.size() && events[next_event].frame <= frame)
+            actions.push_back(events[next_event++].action);
+    }
+
+    ReplayPlayer::ReplayPlayer(const Replay &replay, Simulation &sim)
+        : replay(&replay),
+          sim(&sim),
+          input(replay),
+          actions() {
+        sim = Simulation(replay.header.seed, replay.header.rules);
+    }
+
+    StepResult ReplayPlayer::step() {
+        if (finished()) return StepResult{false, 0};
+        actions.clear();
+        input.actions_at(sim->get_frame(), actions);
+        return sim->step(actions);
+    }
+
+    void ReplayPlayer::seek(std::uint64_t frame) {
+        frame = std::min(frame, replay->end_frame);
+        const std::vector<ReplayCheckpoint> &checkpoints = replay->checkpoints;
+        auto after = std::upper_bound(checkpoints.begin(), checkpoints.end(), frame,
+                                      [] (std::uint64_t f, const ReplayCheckpoint &c) { return f < c.state.frame; });
+        const ReplayCheckpoint *checkpoint = after != checkpoints.begin() ? &*(after - 1) : nullptr;
+        const std::uint64_t checkpoint_frame = checkpoint != nullptr ? checkpoint->state.frame : 0;
+
+        // going on from the current frame is only worth it when no stored state is closer
+        const std::uint64_t current = sim->get_frame();
+        if (current > frame || current < checkpoint_frame || (sim->is_game_over() && current < frame)) {
+            if (checkpoint != nullptr) {
+                sim->restore(checkpoint->state);
+                input.seek_event(checkpoint->next_event);
+            } else {
+                *sim = Simulation(replay->header.seed, replay->header.rules);
+                input.rewind();
+            }
+        }
+        while (sim->get_frame() < frame && !finished())
+            step();
+    }
+}
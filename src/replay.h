@@ -0,0 +1,119 @@
+#ifndef REPLAY_H_
+#define REPLAY_H_
+#include "sim.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <vector>
+
+namespace tetriskl {
+    constexpr std::uint32_t REPLAY_VERSION = 3;
+
+    // struktūra ReplayHeader satur visu, kas vajadzīgs, lai spēli atkārtotu no sākuma
+    struct ReplayHeader {
+        std::uint32_t version;
+        std::uint32_t seed;
+        Ruleset rules;
+    };
+
+    // struktūra ReplayEvent ir viena darbība, kas izpildīta kadrā frame
+    struct ReplayEvent {
+        std::uint64_t frame;
+        Action action;
+    };
+
+    // struktūra ReplayCheckpoint ir ierakstā saglabāts spēles stāvoklis, no kura atkārtošanu var turpināt
+    struct ReplayCheckpoint {
+        Simulation::Checkpoint state;
+        // the first event at or after the checkpoint's frame
+        std::size_t next_event;
+    };
+
+    // struktūra Replay ir nolasīts ieraksts: galvene, visas darbības un stāvokļi pēc kārtas un kadrs, kurā
+    // ieraksts beidzas
+    struct Replay {
+        ReplayHeader header;
+        std::vector<ReplayEvent> events;
+        std::vector<ReplayCheckpoint> checkpoints;
+        std::uint64_t end_frame;
+    };
+
+    // Klase ReplayEncoder pa daļām kodē spēles ierakstu baitos. Ieraksts sākas ar "TKLR" un galveni, pēc kuras
+    // katrs notikums ir viens varint: kadru skaits kopš iepriekšējā notikuma, pareizināts ar 8, plus darbības
+    // numurs, tāpēc parasta darbība aizņem vienu vai divus baitus. Numuram 7 seko ieraksta veids: 0 ir ieraksta
+    // beigas, bet 1 ir stāvoklis, kurā lauciņš ir saspiests bitos.
+    // Versijas 1 ierakstos stāvokļu nav, un numurs 7 bez veida nozīmē beigas. Līdz versijai 3 galvenē nav
+    // Randomizer veida, jo visas spēles izmantoja LEGACY_BAG_7, un versijas 2 stāvokļos gabalu izvēle ir
+    // saglabāta tikai kā izdalīto gabalu skaits.
+    class ReplayEncoder {
+    private:
+        std::vector<std::uint8_t> bytes;
+        std::uint64_t last_frame;
+
+        void put_varint(std::uint64_t value);
+        void put_piece(const Tetromino &piece);
+    public:
+        ReplayEncoder();
+
+        // metode begin(header) sāk jaunu ierakstu ar galveni header
+        void begin(const ReplayHeader &header);
+        // metode add(frame, action) pievieno darbību action kadrā frame; kadriem jābūt nedilstošiem
+        void add(std::uint64_t frame, Action action);
+        // metode add_checkpoint(state) pievieno spēles stāvokli state tā kadrā
+        void add_checkpoint(const Simulation::Checkpoint &state);
+        // metode end(frame) pabeidz ierakstu kadrā frame
+        void end(std::uint64_t frame);
+
+        // metode data() atgriež baitus, kas kodēti kopš pēdējā clear_data() izsaukuma
+        const std::vector<std::uint8_t>& data() const { return bytes; }
+        void clear_data() { bytes.clear(); }
+    };
+
+    // funkcija read_replay(input, replay) nolasa visu ierakstu no input; ja tas nav derīgs ieraksts vai ir
+    // nepabeigts, tiek atgriezts false, bet replay satur to, kas bija nolasāms
+    bool read_replay(std::istream &input, Replay &replay);
+
+    // Klase ReplayInput atkārtošanas laikā dod katram kadram tajā ierakstītās darbības.
+    class ReplayInput {
+    private:
+        const Replay *replay;
+        std::size_t next_event;
+    public:
+        explicit ReplayInput(const Replay &replay);
+
+        // metode actions_at(frame, actions) pievieno actions visas kadra frame darbības; kadriem jānāk pēc kārtas
+        void actions_at(std::uint64_t frame, std::vector<Action> &actions);
+        // metode finished(frame) pārbauda, vai ieraksts ir beidzies līdz kadram frame
+        bool finished(std::uint64_t frame) const { return frame >= replay->end_frame; }
+        // metode rewind() atgriežas ieraksta sākumā
+        void rewind() { next_event = 0; }
+        // metode seek_event(event) turpina ar darbību numur event
+        void seek_event(std::size_t event) { next_event = event; }
+
+        const Replay& get_replay() const { return *replay; }
+    };
+
+    // Klase ReplayPlayer atkārto ierakstu simulācijā sim un ļauj pāriet uz jebkuru kadru: tiek atjaunots tuvākais
+    // iepriekšējais ierakstā saglabātais stāvoklis, un no tā tiek simulēts uz priekšu, tāpēc pāreja nekad neprasa
+    // vairāk kadru par attālumu starp stāvokļiem.
+    class ReplayPlayer {
+    private:
+        const Replay *replay;
+        Simulation *sim;
+        ReplayInput input;
+        std::vector<Action> actions;
+    public:
+        // konstruktors ReplayPlayer(replay, sim) sāk ierakstu replay no sākuma simulācijā sim
+        ReplayPlayer(const Replay &replay, Simulation &sim);
+
+        // metode finished() pārbauda, vai ieraksts ir atkārtots līdz beigām vai spēle ir beigusies
+        bool finished() const { return input.finished(sim->get_frame()) || sim->is_game_over(); }
+        // metode step() pavirza simulāciju par vienu kadru ar ierakstītajām darbībām, ja ieraksts vēl nav beidzies
+        StepResult step();
+        // metode seek(frame) pāriet uz kadru frame vai ieraksta beigām, ja tas ir tālāk
+        void seek(std::uint64_t frame);
+    };
+}
+
+#endif // REPLAY_H_
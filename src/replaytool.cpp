@@ -0,0 +1,84 @@
+#include "replay.h"
+#include "sim.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+// tetriskl-replay replay...
+//
+// Plays every given recording back without a window and prints its seed, length, size and final result, so
+// a reported score can be checked against the recorded input. Every checkpoint in the recording is compared
+// with the state the input leads to, and a recording whose checkpoints disagree with it is reported as broken.
+
+namespace {
+    using tetriskl::Simulation;
+
+    bool same_piece(const tetriskl::Tetromino &a, const tetriskl::Tetromino &b) {
+        return a.type() == b.type() && a.rotation() == b.rotation();
+    }
+
+    bool same_state(const Simulation::Checkpoint &a, const Simulation::Checkpoint &b) {
+        if (a.board.row_masks() != b.board.row_masks()) return false;
+        for (std::size_t y = 0; y < Simulation::Board::rows; y++)
+            for (std::size_t x = 0; x < Simulation::Board::columns; x++)
+                if (a.board[sf::Vector2u(x, y)] != b.board[sf::Vector2u(x, y)]) return false;
+        return a.frame == b.frame
+            && same_piece(a.falling_piece, b.falling_piece) && same_piece(a.next_piece, b.next_piece)
+            && a.falling_piece_pos == b.falling_piece_pos
+            && a.falling_piece_active == b.falling_piece_active && a.game_over == b.game_over
+            && a.score == b.score && a.lines == b.lines
+            && a.gravity_counter == b.gravity_counter && a.lock_counter == b.lock_counter
+            && a.provider == b.provider;
+    }
+}
+
+int main(int argc, const char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " replay..." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    int status = EXIT_SUCCESS;
+    for (int i = 1; i < argc; i++) {
+        std::ifstream input(argv[i], std::ios::binary);
+        tetriskl::Replay replay;
+        bool complete = tetriskl::read_replay(input, replay);
+        input.clear();
+        std::streamoff size = input.seekg(0, std::ios::end).tellg();
+        if (!complete && replay.end_frame == 0) {
+            std::cerr << argv[i] << ": not a replay" << std::endl;
+            status = EXIT_FAILURE;
+            continue;
+        }
+
+        Simulation sim(replay.header.seed, replay.header.rules);
+        tetriskl::ReplayPlayer player(replay, sim);
+        std::size_t checkpoints_matched = 0;
+        // stepping instead of seeking, which would just restore the checkpoints being checked
+        for (const tetriskl::ReplayCheckpoint &checkpoint : replay.checkpoints) {
+            while (sim.get_frame() < checkpoint.state.frame && !player.finished())
+                player.step();
+            if (!same_state(sim.checkpoint(), checkpoint.state)) break;
+            checkpoints_matched++;
+        }
+        while (!player.finished())
+            player.step();
+        bool broken = checkpoints_matched < replay.checkpoints.size();
+        if (broken) status = EXIT_FAILURE;
+
+        std::cout << argv[i] << ": seed " << replay.header.seed
+                  << ", " << tetriskl::randomizer_name(replay.header.rules.randomizer) << " randomizer"
+                  << ", " << sim.get_frame() << " frames"
+                  << ", " << replay.events.size() << " inputs"
+                  << ", " << replay.checkpoints.size() << " checkpoints"
+                  << ", " << size << " bytes"
+                  << ", score " << sim.get_score()
+                  << ", lines " << sim.get_lines()
+                  << (sim.is_game_over() ? ", game over" : "")
+                  << (complete ? "" : ", cut off")
+                  << (broken ? ", checkpoint mismatch" : "") << std::endl;
+    }
+    return status;
+}
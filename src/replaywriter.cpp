@@ -0,0 +1,133 @@
+#include "replaywriter.h"
+#include "dirs.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+
+namespace tetriskl {
+    const sf::Time ReplayWriter::idle_poll_period = sf::milliseconds(5);
+
+    ReplayWriter::ReplayWriter(const std::string &directory)
+        : directory(directory),
+          chunks(),
+          running(false),
+          thread(),
+          backlog() {}
+
+    ReplayWriter::~ReplayWriter() {
+        stop();
+    }
+
+    void ReplayWriter::start() {
+        if (running.exchange(true)) return;
+        thread = std::thread([this] () { run(); });
+    }
+
+    void ReplayWriter::stop() {
+        if (!running.load(std::memory_order_acquire)) return;
+        // the thread stops once the queue is empty, so the backlog goes in first, as much as fits at a time
+        while (!backlog.empty()) {
+            flush();
+            sf::sleep(ReplayWriter::idle_poll_period);
+        }
+        running.store(false, std::memory_order_release);
+        if (thread.joinable())
+            thread.join();
+    }
+
+    void ReplayWriter::enqueue(const Chunk &chunk) {
+        backlog.push_back(chunk);
+        flush();
+    }
+
+    void ReplayWriter::flush() {
+        while (!backlog.empty() && chunks.push(backlog.front()))
+            backlog.pop_front();
+    }
+
+    void ReplayWriter::open(std::uint32_t seed) {
+        Chunk chunk;
+        chunk.type = Chunk::Type::OPEN;
+        chunk.seed = seed;
+        chunk.size = 0;
+        enqueue(chunk);
+    }
+
+    void ReplayWriter::write(const std::uint8_t *bytes, std::size_t size) {
+        // the last chunk in the backlog is topped up first, so small writes don't each take a whole chunk
+        if (!backlog.empty() && backlog.back().type == Chunk::Type::DATA) {
+            Chunk &last = backlog.back();
+            std::size_t n = std::min(size, Chunk::capacity - last.size);
+            std::copy(bytes, bytes + n, last.bytes.begin() + last.size);
+            last.size += n;
+            bytes += n;
+            size -= n;
+        }
+        while (size > 0) {
+            Chunk chunk;
+            chunk.type = Chunk::Type::DATA;
+            chunk.seed = 0;
+            chunk.size = std::min(size, Chunk::capacity);
+            std::copy(bytes, bytes + chunk.size, chunk.bytes.begin());
+            backlog.push_back(chunk);
+            bytes += chunk.size;
+            size -= chunk.size;
+        }
+        flush();
+    }
+
+    void ReplayWriter::close() {
+        Chunk chunk;
+        chunk.type = Chunk::Type::CLOSE;
+        chunk.seed = 0;
+        chunk.size = 0;
+        enqueue(chunk);
+    }
+
+    void ReplayWriter::run() {
+        bool created_directory = false;
+        std::ofstream file;
+        Chunk chunk;
+        for (;;) {
+            if (!chunks.pop(chunk)) {
+                if (running.load(std::memory_order_acquire)) {
+                    sf::sleep(ReplayWriter::idle_poll_period);
+                    continue;
+                }
+                // stop() only gets here once everything is in the queue, so another miss means it's all written
+                if (!chunks.pop(chunk)) break;
+            }
+            if (directory.empty()) continue;
+
+            switch (chunk.type) {
+            case Chunk::Type::OPEN: {
+                if (!created_directory) {
+                    make_directory(directory);
+                    created_directory = true;
+                }
+                // the start time and the seed keep the names apart and sort them by date
+                char name[64];
+                std::snprintf(name, sizeof(name), "%010lld-%08x.tklr", static_cast<long long>(std::time(nullptr)),
+                              static_cast<unsigned int>(chunk.seed));
+                std::string path = join_path(directory, name);
+                file.close();
+                file.clear();
+                file.open(path, std::ios::binary | std::ios::trunc);
+                if (!file) std::cerr << "cannot write replay " << path << std::endl;
+                break;
+            }
+            case Chunk::Type::DATA:
+                if (file.is_open())
+                    file.write(reinterpret_cast<const char*>(chunk.bytes.data()), chunk.size);
+                break;
+            case Chunk::Type::CLOSE:
+                file.close();
+                break;
+            }
+        }
+        file.close();
+    }
+}
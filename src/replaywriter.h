@@ -0,0 +1,69 @@
+#ifndef REPLAYWRITER_H_
+#define REPLAYWRITER_H_
+#include "lockfree.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <thread>
+#include <SFML/System.hpp>
+
+namespace tetriskl {
+    // Klase ReplayWriter raksta ierakstu baitus failos savā pavedienā, lai diska gaidīšana nekad neaizturētu
+    // simulāciju. Rakstītājs (simulācijas pavediens) nodod baitus gabalos caur SpscQueue; ja rinda ir pilna,
+    // gabali paliek rakstītāja pusē līdz nākamajam flush() izsaukumam, tāpēc neviens izsaukums negaida.
+    class ReplayWriter {
+    private:
+        struct Chunk {
+            enum class Type {
+                OPEN,
+                DATA,
+                CLOSE,
+            };
+
+            constexpr static std::size_t capacity = 256;
+
+            Type type;
+            std::uint32_t seed;
+            std::size_t size;
+            std::array<std::uint8_t, capacity> bytes;
+        };
+
+        std::string directory;
+        SpscQueue<Chunk, 64> chunks;
+        std::atomic<bool> running;
+        std::thread thread;
+
+        // used only by the producer
+        std::deque<Chunk> backlog;
+
+        const static sf::Time idle_poll_period;
+
+        void run();
+        void enqueue(const Chunk &chunk);
+    public:
+        // konstruktors ReplayWriter(directory) raksta ierakstus mapē directory; tukšs directory nozīmē, ka
+        // ieraksti tiek izmesti
+        explicit ReplayWriter(const std::string &directory);
+        ~ReplayWriter();
+        ReplayWriter(const ReplayWriter&) = delete;
+        ReplayWriter& operator=(const ReplayWriter&) = delete;
+
+        void start();
+        // metode stop() uzraksta visu, kas vēl nav uzrakstīts, un aptur pavedienu; pēc tās drīkst tikai start()
+        void stop();
+
+        // metodes open(seed), write(bytes, size) un close() sāk jaunu ieraksta failu, turpina un pabeidz to;
+        // tās drīkst izsaukt tikai rakstītājs, un tās nekad negaida
+        void open(std::uint32_t seed);
+        void write(const std::uint8_t *bytes, std::size_t size);
+        void close();
+        // metode flush() nodod rakstītāja pusē palikušos gabalus pavedienam, cik to ietilpst rindā
+        void flush();
+    };
+}
+
+#endif // REPLAYWRITER_H_
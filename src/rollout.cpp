@@ -0,0 +1,105 @@
+#include "batchsim.h"
+#include "sim.h"
+#include "tetro.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// tetriskl-rollout [games] [max-pieces] [seed] [verify]
+//
+// Plays the given number of random-move games at once with BatchSimulator until all of them are over or have
+// placed max-pieces pieces, and prints how many pieces per second that is. With verify set to 1 every game is
+// also replayed move by move on its own Simulation::Board, comparing the boards, the lines and the end of the
+// game after every step, and the single board engine's speed on the same moves is printed for comparison.
+
+namespace {
+    using tetriskl::BatchMove;
+    using tetriskl::BatchSimulator;
+    using tetriskl::Simulation;
+    using tetriskl::Tetromino;
+
+    struct ReferenceGame {
+        Simulation::Board board;
+        unsigned int lines;
+        bool game_over;
+    };
+
+    // the same rules as BatchSimulator::step, one board at a time
+    void reference_step(ReferenceGame &game, tetriskl::Cell kind, const BatchMove &move, tetriskl::Cell next) {
+        Tetromino piece(kind, move.rotation);
+        sf::Vector2u pos(move.column, Simulation::spawn_pos.y);
+        if (!game.board.can_place(pos, piece)) {
+            piece = Tetromino(kind);
+            pos = Simulation::spawn_pos;
+        }
+        pos.y += game.board.drop_distance(pos, piece);
+        game.board.place(pos, piece);
+        game.lines += game.board.remove_full_rows(pos.y, pos.y + piece.state().height);
+        game.game_over = !game.board.can_place(Simulation::spawn_pos, Tetromino(next));
+    }
+
+    bool matches(const ReferenceGame &game, const BatchSimulator &batch, std::size_t index) {
+        if (game.lines != batch.get_lines(index) || game.game_over != batch.is_game_over(index)) return false;
+        for (std::size_t y = 0; y < Simulation::Board::rows; y++)
+            if (game.board.row(y) != batch.row(index, y)) return false;
+        return true;
+    }
+}
+
+int main(int argc, const char *argv[]) {
+    std::size_t num_games = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4096;
+    unsigned int max_pieces = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+    std::uint64_t seed = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 0;
+    bool verify = argc > 4 && std::strtoul(argv[4], nullptr, 10) != 0;
+    if (num_games == 0) {
+        std::cerr << "usage: " << argv[0] << " [games] [max-pieces] [seed] [verify]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    BatchSimulator batch(num_games, seed);
+    std::vector<BatchMove> moves(num_games);
+    std::vector<ReferenceGame> reference(verify ? num_games : 0, ReferenceGame{Simulation::Board(), 0, false});
+    std::vector<tetriskl::Cell> pieces(num_games);
+
+    double batch_seconds = 0.0;
+    double reference_seconds = 0.0;
+    std::uint64_t total_pieces = 0;
+    for (unsigned int step = 0; step < max_pieces && batch.num_active() > 0; step++) {
+        batch.random_moves(moves.data());
+        for (std::size_t i = 0; i < num_games; i++)
+            pieces[i] = batch.get_piece(i);
+
+        auto start = std::chrono::steady_clock::now();
+        batch.step(moves.data());
+        batch_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (!verify) continue;
+
+        start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < num_games; i++)
+            if (!reference[i].game_over)
+                reference_step(reference[i], pieces[i], moves[i], batch.get_piece(i));
+        reference_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        for (std::size_t i = 0; i < num_games; i++) {
+            if (!matches(reference[i], batch, i)) {
+                std::cerr << "game " << i << " differs from the single board engine after step " << step << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    for (std::size_t i = 0; i < num_games; i++)
+        total_pieces += batch.get_pieces(i);
+
+    std::cout << total_pieces << " pieces in " << num_games << " games, " << batch.num_active() << " still going"
+              << std::endl;
+    std::cout << "batch (" << BatchSimulator::lane_width() << " lanes): "
+              << static_cast<std::uint64_t>(total_pieces / batch_seconds) << " pieces/s" << std::endl;
+    if (verify) {
+        std::cout << "single board: " << static_cast<std::uint64_t>(total_pieces / reference_seconds) << " pieces/s"
+                  << std::endl << "all games match" << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
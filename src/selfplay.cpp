@@ -0,0 +1,108 @@
+#include "autoplay.h"
+#include "bot.h"
+#include "workpool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// tetriskl-selfplay output [games] [first-seed] [max-pieces] [threads] [randomizer]
+//
+// Lets the bot play games with seeds first-seed, first-seed + 1, ... on every core without a window, and
+// writes the totals, the score distribution and every game's result to the file output, so changes to the
+// scoring or the piece randomizer can be checked over many games at once. The randomizer is one of 7bag
+// (the default), 14bag, memoryless, tgm and legacy.
+
+namespace {
+    using tetriskl::GameResult;
+
+    unsigned int percentile(const std::vector<unsigned int> &sorted, unsigned int percent) {
+        return sorted[(sorted.size() - 1) * percent / 100];
+    }
+}
+
+int main(int argc, const char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " output [games] [first-seed] [max-pieces] [threads] [randomizer]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::size_t num_games = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100;
+    std::uint32_t first_seed = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 0;
+    unsigned int max_pieces = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 1000;
+    std::size_t num_threads = argc > 5 ? std::strtoul(argv[5], nullptr, 10) : 0;
+    tetriskl::Ruleset rules = tetriskl::default_ruleset;
+    if (argc > 6 && !tetriskl::parse_randomizer(argv[6], rules.randomizer)) {
+        std::cerr << "unknown randomizer " << argv[6] << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (num_games == 0) {
+        std::cerr << "nothing to play" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream output(argv[1]);
+    if (!output) {
+        std::cerr << "cannot open " << argv[1] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::uint32_t> seeds;
+    for (std::size_t i = 0; i < num_games; i++)
+        seeds.push_back(first_seed + i);
+
+    tetriskl::WorkStealingPool pool(num_threads);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<GameResult> results = tetriskl::play_games(pool, seeds, tetriskl::default_bot_weights, max_pieces,
+                                                           rules);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::uint64_t total_score = 0;
+    std::uint64_t total_lines = 0;
+    std::uint64_t total_pieces = 0;
+    std::size_t games_over = 0;
+    std::vector<unsigned int> scores;
+    for (const GameResult &result : results) {
+        total_score += result.score;
+        total_lines += result.lines;
+        total_pieces += result.pieces;
+        if (result.game_over) games_over++;
+        scores.push_back(result.score);
+    }
+    std::sort(scores.begin(), scores.end());
+
+    output << "games " << num_games << "\n"
+           << "threads " << pool.size() << "\n"
+           << "max_pieces " << max_pieces << "\n"
+           << "randomizer " << tetriskl::randomizer_name(rules.randomizer) << "\n"
+           << "games_over " << games_over << "\n"
+           << "seconds " << seconds << "\n"
+           << "games_per_second " << num_games / seconds << "\n"
+           << "pieces " << total_pieces << "\n"
+           << "pieces_per_game " << static_cast<double>(total_pieces) / num_games << "\n"
+           << "pieces_per_second " << total_pieces / seconds << "\n"
+           << "lines " << total_lines << "\n"
+           << "lines_per_game " << static_cast<double>(total_lines) / num_games << "\n"
+           << "score_mean " << static_cast<double>(total_score) / num_games << "\n";
+    for (unsigned int percent : {0, 10, 25, 50, 75, 90, 100})
+        output << "score_p" << percent << " " << percentile(scores, percent) << "\n";
+
+    output << "\nseed score lines pieces game_over\n";
+    for (const GameResult &result : results) {
+        output << result.seed << " " << result.score << " " << result.lines << " " << result.pieces << " "
+               << result.game_over << "\n";
+    }
+
+    output.close();
+    if (!output) {
+        std::cerr << "cannot write " << argv[1] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << num_games << " games in " << seconds << " s, " << num_games / seconds << " games/s" << std::endl;
+    return EXIT_SUCCESS;
+}
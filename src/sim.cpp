@@ -0,0 +1,191 @@
+#include "sim.h"
+
+#include <algorithm>
+#include <random>
+#include <SFML/System.hpp>
+
+namespace tetriskl {
+    const sf::Vector2u Simulation::spawn_pos{3, 9};
+
+    Simulation::Simulation(const Ruleset &rules) : Simulation(std::random_device()(), rules) {}
+
+    Simulation::Simulation(std::uint32_t seed, const Ruleset &rules)
+        : rules(rules),
+          seed(seed),
+          board(),
+          falling_piece_active(false),
+          landing_row(0),
+          game_over(false),
+          score(0),
+          lines(0),
+          frame(0),
+          gravity_counter(0),
+          lock_counter(0),
+          provider(seed, rules.randomizer),
+          num_cleared_lines(0) {
+        for (int i = 0; i < 2; i++)
+            new_piece();
+    }
+
+    Simulation::Checkpoint Simulation::checkpoint() const {
+        return Checkpoint{frame, board, falling_piece, next_piece, falling_piece_pos, falling_piece_active, game_over,
+                          score, lines, gravity_counter, lock_counter, provider.get_state()};
+    }
+
+    void Simulation::restore(const Checkpoint &checkpoint) {
+        frame = checkpoint.frame;
+        board = checkpoint.board;
+        falling_piece = checkpoint.falling_piece;
+        next_piece = checkpoint.next_piece;
+        falling_piece_pos = checkpoint.falling_piece_pos;
+        falling_piece_active = checkpoint.falling_piece_active;
+        game_over = checkpoint.game_over;
+        score = checkpoint.score;
+        lines = checkpoint.lines;
+        gravity_counter = checkpoint.gravity_counter;
+        lock_counter = checkpoint.lock_counter;
+
+        provider.set_state(checkpoint.provider);
+
+        landing_row = falling_piece_pos.y;
+        if (falling_piece_active && !game_over) update_landing_row();
+        pre_clear_board = board;
+        num_cleared_lines = 0;
+    }
+
+    bool Simulation::new_piece() {
+        falling_piece = next_piece;
+        falling_piece_pos = Simulation::spawn_pos;
+        falling_piece_active = true;
+        gravity_counter = 0;
+        lock_counter = 0;
+        next_piece = provider.next();
+        landing_row = falling_piece_pos.y;
+        if (!board.can_place(falling_piece_pos, falling_piece)) return false;
+        update_landing_row();
+        return true;
+    }
+
+    bool Simulation::move(sf::Vector2i dir) {
+        sf::Vector2i new_pos = sf::Vector2i(falling_piece_pos) + dir;
+        if (new_pos.x < 0 || new_pos.y < 0) return false;
+        sf::Vector2u unew_pos = sf::Vector2u(new_pos);
+        if (!board.can_place(unew_pos, falling_piece)) return false;
+        falling_piece_pos = unew_pos;
+        // falling straight down never changes where the piece lands
+        if (dir.x != 0) update_landing_row();
+        return true;
+    }
+
+    void Simulation::update_landing_row() {
+        landing_row = falling_piece_pos.y + board.drop_distance(falling_piece_pos, falling_piece);
+    }
+
+    void Simulation::apply(Action action, StepResult &result) {
+        switch (action) {
+        case Action::MOVE_LEFT:
+            move(sf::Vector2i(-1, 0));
+            break;
+        case Action::MOVE_RIGHT:
+            move(sf::Vector2i(1, 0));
+            break;
+        case Action::SOFT_DROP:
+            move(sf::Vector2i(0, 1));
+            break;
+        case Action::HARD_DROP:
+            falling_piece_pos.y = landing_row;
+            lock(result);
+            break;
+        case Action::ROTATE_CCW:
+            falling_piece.rotate_ccw(board, falling_piece_pos);
+            update_landing_row();
+            break;
+        case Action::ROTATE_CW:
+            falling_piece.rotate_cw(board, falling_piece_pos);
+            update_landing_row();
+            break;
+        case Action::ROTATE_180:
+            falling_piece.rotate_180(board, falling_piece_pos);
+            update_landing_row();
+            break;
+        }
+    }
+
+    void Simulation::award_points(unsigned int lines_cleared) {
+        score += points_for_lines(lines_cleared);
+    }
+
+    unsigned int Simulation::clear_lines() {
+        std::size_t num_full_lines = 0;
+        for (std::size_t y = 0; y < Board::rows; y++) {
+            if (board.row_full(y))
+                cleared_lines[num_full_lines++] = y;
+        }
+        if (num_full_lines == 0) return 0;
+
+        num_cleared_lines = num_full_lines;
+        pre_clear_board = board;
+        award_points(num_cleared_lines);
+        lines += num_cleared_lines;
+        for (std::size_t i = 0; i < num_cleared_lines; i++)
+            board.remove_row(cleared_lines[i]);
+        return num_cleared_lines;
+    }
+
+    void Simulation::lock(StepResult &result) {
+        board.place(falling_piece_pos, falling_piece);
+        falling_piece_active = false;
+        result.piece_locked = true;
+        result.lines_cleared += clear_lines();
+        if (!new_piece()) game_over = true;
+    }
+
+    void Simulation::fall(StepResult &result) {
+        if (game_over) return;
+        const Gravity &gravity = rules.gravity[std::min<std::size_t>(get_level(), NUM_LEVELS - 1)];
+        unsigned int distance = landing_row - falling_piece_pos.y;
+        if (++gravity_counter >= gravity.frames) {
+            gravity_counter = 0;
+            unsigned int rows = std::min(gravity.rows, distance);
+            falling_piece_pos.y += rows;
+            distance -= rows;
+        }
+
+        if (distance > 0) {
+            lock_counter = 0;
+        } else if (++lock_counter >= rules.lock_delay_frames) {
+            // piece has rested on the stack for long enough
+            lock(result);
+        }
+    }
+
+    StepResult Simulation::step(const Action *actions, std::size_t num_actions) {
+        StepResult result{false, 0};
+        if (game_over) return result;
+
+        for (std::size_t i = 0; i < num_actions && !game_over; i++)
+            apply(actions[i], result);
+
+        frame++;
+        fall(result);
+        return result;
+    }
+
+    StepResult Simulation::step(const std::vector<Action> &actions) {
+        return step(actions.data(), actions.size());
+    }
+
+    StepResult Simulation::apply_action(Action action) {
+        StepResult result{false, 0};
+        if (!game_over) apply(action, result);
+        return result;
+    }
+
+    StepResult Simulation::advance() {
+        StepResult result{false, 0};
+        if (game_over) return result;
+        frame++;
+        fall(result);
+        return result;
+    }
+}
@@ -0,0 +1,166 @@
+#ifndef SIM_H_
+#define SIM_H_
+#include "tetro.h"
+#include "bitgrid.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <SFML/System.hpp>
+
+namespace tetriskl {
+    // uzskaitījums Action attēlo vienu spēlētāja darbību vienā loģiskajā kadrā
+    enum class Action {
+        MOVE_LEFT,
+        MOVE_RIGHT,
+        SOFT_DROP,
+        HARD_DROP,
+        ROTATE_CCW,
+        ROTATE_CW,
+        ROTATE_180,
+    };
+
+    // struktūra StepResult apraksta, kas notika vienā Simulation::step izsaukumā
+    struct StepResult {
+        bool piece_locked;
+        unsigned int lines_cleared;
+    };
+
+    // struktūra Gravity apraksta krišanas ātrumu vienā līmenī: ik pēc frames kadriem gabals nokrīt par rows rindām
+    struct Gravity {
+        unsigned int rows;
+        unsigned int frames;
+    };
+
+    constexpr std::size_t NUM_LEVELS = 20;
+
+    // struktūra Ruleset apraksta spēles noteikumus, kas nemainās spēles laikā
+    struct Ruleset {
+        // loģisko kadru skaits sekundē
+        unsigned int frame_rate;
+        // notīrīto rindu skaits, pēc kura spēle pāriet nākamajā līmenī
+        unsigned int lines_per_level;
+        // kadru skaits, ko gabals var gulēt uz virsmas, pirms tas tiek nofiksēts
+        unsigned int lock_delay_frames;
+        // krišanas ātrums katrā līmenī; pēdējais līmenis tiek izmantots arī visiem nākamajiem
+        Gravity gravity[NUM_LEVELS];
+        // veids, kā tiek izvēlēti gabali
+        Randomizer randomizer;
+    };
+
+    // līmenis 0 krīt par rindu ik pēc pussekundes, bet pēdējais līmenis ir 20G: gabals nokrīt uzreiz
+    constexpr Ruleset default_ruleset{60, 10, 30, {
+        {1, 30}, {1, 25}, {1, 20}, {1, 16}, {1, 13}, {1, 10}, {1, 8}, {1, 6}, {1, 5}, {1, 4},
+        {1, 3}, {1, 2}, {1, 1}, {2, 1}, {3, 1}, {5, 1}, {8, 1}, {12, 1}, {16, 1}, {20, 1},
+    }, Randomizer::BAG_7};
+
+    // funkcija points_for_lines(lines_cleared) atgriež punktus par lines_cleared rindu notīrīšanu ar vienu gabalu
+    constexpr unsigned int points_for_lines(unsigned int lines_cleared) {
+        return lines_cleared == 0 ? 0
+            : lines_cleared == 1 ? 100
+            : lines_cleared == 2 ? 300
+            : lines_cleared == 3 ? 500
+            : lines_cleared == 4 ? 800
+            : 200 * lines_cleared;
+    }
+
+    // Klase Simulation ir spēles loģika bez loga, pulksteņa un gaidīšanas: laiks tiek mērīts loģiskajos
+    // kadros, un katrs step izsaukums apstrādā dotās darbības un pavirza spēli par vienu kadru uz priekšu.
+    // Ar vienādu sēklu un vienādām darbībām tā vienmēr nonāk tajā pašā stāvoklī.
+    class Simulation {
+    public:
+        using Board = BitCellGrid<10, 30>;
+        const static sf::Vector2u spawn_pos;
+
+        // struktūra Checkpoint satur visu spēles stāvokli, no kura to var turpināt ar restore()
+        struct Checkpoint {
+            std::uint64_t frame;
+            Board board;
+            Tetromino falling_piece;
+            Tetromino next_piece;
+            sf::Vector2u falling_piece_pos;
+            bool falling_piece_active;
+            bool game_over;
+            unsigned int score;
+            unsigned int lines;
+            unsigned int gravity_counter;
+            unsigned int lock_counter;
+            TetrominoProvider::State provider;
+        };
+
+    private:
+        Ruleset rules;
+        std::uint32_t seed;
+        Board board;
+        Tetromino falling_piece;
+        Tetromino next_piece;
+        bool falling_piece_active;
+        sf::Vector2u falling_piece_pos;
+        // the row the falling piece would land on, kept up to date only when it can change
+        unsigned int landing_row;
+        bool game_over;
+        unsigned int score;
+        unsigned int lines;
+        std::uint64_t frame;
+        unsigned int gravity_counter;
+        unsigned int lock_counter;
+        TetrominoProvider provider;
+
+        Board pre_clear_board;
+        std::array<unsigned int, Board::rows> cleared_lines;
+        std::size_t num_cleared_lines;
+
+        bool new_piece();
+        bool move(sf::Vector2i dir);
+        void update_landing_row();
+        void apply(Action action, StepResult &result);
+        void award_points(unsigned int lines_cleared);
+        unsigned int clear_lines();
+        void lock(StepResult &result);
+        void fall(StepResult &result);
+    public:
+        explicit Simulation(const Ruleset &rules = default_ruleset);
+        explicit Simulation(std::uint32_t seed, const Ruleset &rules = default_ruleset);
+
+        // metode step(actions, num_actions) izpilda darbības actions un pavirza spēli par vienu kadru
+        StepResult step(const Action *actions, std::size_t num_actions);
+        StepResult step(const std::vector<Action> &actions);
+
+        // metodes apply_action(action) un advance() ir step sadalīts pa daļām: step(actions) dara to pašu, ko
+        // apply_action katrai darbībai pēc kārtas un pēc tam advance(). Tās ļauj redzēt, kura darbība nofiksē gabalu.
+        StepResult apply_action(Action action);
+        StepResult advance();
+
+        // metode checkpoint() atgriež pašreizējo stāvokli
+        Checkpoint checkpoint() const;
+        // metode restore(checkpoint) atjauno stāvokli checkpoint, kam jābūt iegūtam no spēles ar to pašu sēklu un
+        // noteikumiem; pēdējās rindu notīrīšanas apraksts netiek atjaunots
+        void restore(const Checkpoint &checkpoint);
+
+        const Ruleset& get_rules() const { return rules; }
+        std::uint32_t get_seed() const { return seed; }
+        const Board& get_board() const { return board; }
+        const Tetromino& get_falling_piece() const { return falling_piece; }
+        const Tetromino& get_next_piece() const { return next_piece; }
+        bool is_falling_piece_active() const { return falling_piece_active; }
+        sf::Vector2u get_falling_piece_pos() const { return falling_piece_pos; }
+        // metode get_landing_pos() atgriež pozīciju, kurā krītošais gabals nonāktu pēc krišanas līdz galam
+        sf::Vector2u get_landing_pos() const { return sf::Vector2u(falling_piece_pos.x, landing_row); }
+        bool is_game_over() const { return game_over; }
+        unsigned int get_score() const { return score; }
+        unsigned int get_lines() const { return lines; }
+        unsigned int get_level() const { return lines / rules.lines_per_level; }
+        std::uint64_t get_frame() const { return frame; }
+        // metode get_bag_mask() atgriež gabalus, kas pēc nākamā gabala vēl palikuši maisā (sk. TetrominoProvider)
+        std::uint8_t get_bag_mask() const { return provider.bag_mask(); }
+
+        // metodes get_pre_clear_board(), get_cleared_lines() un get_num_cleared_lines() apraksta pēdējo
+        // rindu notīrīšanu: lauciņu pirms tās un notīrīto rindu numurus
+        const Board& get_pre_clear_board() const { return pre_clear_board; }
+        const unsigned int* get_cleared_lines() const { return cleared_lines.data(); }
+        std::size_t get_num_cleared_lines() const { return num_cleared_lines; }
+    };
+}
+
+#endif // SIM_H_
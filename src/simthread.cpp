@@ -0,0 +1,298 @@
+#include "simthread.h"
+
+#include <algorithm>
+#include <random>
+#include <SFML/System.hpp>
+
+namespace tetriskl {
+    const sf::Time SimulationThread::input_poll_period = sf::milliseconds(1);
+
+    SimulationThread::SimulationThread(const Ruleset &rules, const std::string &replay_directory,
+                                       const Replay *replay)
+        : rules(replay != nullptr ? replay->header.rules : rules),
+          playback(replay != nullptr ? new Replay(*replay) : nullptr),
+          clock(),
+          input(),
+          snapshots(),
+          running(false),
+          thread(),
+          sim(this->rules),
+          pending_actions(),
+          step_actions(),
+          sim_time(),
+          paused(false),
+          games(0),
+          locks(0),
+          line_clears(0),
+          bot(),
+          autoplay(false),
+          autoplay_frames(0),
+          hints(nullptr),
+          seed(0),
+          recording(),
+          replay_writer(replay_directory),
+          player(),
+          playback_speed(1),
+          recording_game(false) {
+        begin_game();
+        // the reader has a valid snapshot before the thread ever runs
+        publish();
+        snapshots.update();
+    }
+
+    SimulationThread::~SimulationThread() {
+        stop();
+    }
+
+    void SimulationThread::start() {
+        if (running.exchange(true)) return;
+        replay_writer.start();
+        sim_time = clock.getElapsedTime();
+        thread = std::thread([this] () { run(); });
+    }
+
+    void SimulationThread::stop() {
+        running.store(false, std::memory_order_release);
+        if (thread.joinable())
+            thread.join();
+        // the game that was still going is saved as far as it got
+        end_recording();
+        replay_writer.stop();
+    }
+
+    sf::Time SimulationThread::now() const {
+        return clock.getElapsedTime();
+    }
+
+    bool SimulationThread::send(const InputEvent &event) {
+        return input.push(event);
+    }
+
+    bool SimulationThread::update_snapshot() {
+        return snapshots.update();
+    }
+
+    const FrameSnapshot& SimulationThread::get_snapshot() const {
+        return snapshots.read_buffer();
+    }
+
+    void SimulationThread::publish() {
+        FrameSnapshot &snapshot = snapshots.write_buffer();
+        snapshot.board = sim.get_board();
+        snapshot.falling_piece = sim.get_falling_piece();
+        snapshot.next_piece = sim.get_next_piece();
+        snapshot.falling_piece_pos = sim.get_falling_piece_pos();
+        snapshot.landing_pos = sim.get_landing_pos();
+        snapshot.falling_piece_active = sim.is_falling_piece_active();
+        snapshot.game_over = sim.is_game_over();
+        snapshot.score = sim.get_score();
+        snapshot.frame = sim.get_frame();
+        snapshot.games = games;
+        snapshot.locks = locks;
+        snapshot.line_clears = line_clears;
+        snapshot.pre_clear_board = sim.get_pre_clear_board();
+        snapshot.num_cleared_lines = sim.get_num_cleared_lines();
+        std::copy(sim.get_cleared_lines(), sim.get_cleared_lines() + snapshot.num_cleared_lines,
+                  snapshot.cleared_lines.begin());
+        snapshots.publish();
+    }
+
+    void SimulationThread::begin_game() {
+        end_recording();
+        if (playback) {
+            seed = playback->header.seed;
+            player.reset(new ReplayPlayer(*playback, sim));
+        } else {
+            seed = std::random_device()();
+            sim = Simulation(seed, rules);
+        }
+        pending_actions.clear();
+        autoplay_frames = 0;
+        if (playback) return;
+
+        recording.begin(ReplayHeader{REPLAY_VERSION, seed, rules});
+        replay_writer.open(seed);
+        recording_game = true;
+    }
+
+    void SimulationThread::end_recording() {
+        if (!recording_game) return;
+        recording.end(sim.get_frame());
+        recording_game = false;
+        flush_recording();
+        replay_writer.close();
+        replay_writer.flush();
+    }
+
+    void SimulationThread::flush_recording() {
+        replay_writer.write(recording.data().data(), recording.data().size());
+        recording.clear_data();
+    }
+
+    void SimulationThread::restart() {
+        begin_game();
+        games++;
+        sim_time = clock.getElapsedTime();
+        publish();
+        request_hint();
+    }
+
+    void SimulationThread::request_hint() {
+        if (hints == nullptr) return;
+        if (sim.is_game_over() || !sim.is_falling_piece_active()) {
+            hints->cancel();
+            return;
+        }
+        HintRequest request{};
+        request.rows = sim.get_board().row_masks();
+        request.piece = sim.get_falling_piece();
+        request.next_piece = sim.get_next_piece();
+        request.pos = sim.get_falling_piece_pos();
+        request.bag_mask = sim.get_bag_mask();
+        request.randomizer = sim.get_rules().randomizer;
+        request.games = games;
+        request.locks = locks;
+        hints->analyze(request);
+    }
+
+    void SimulationThread::seek_playback(std::int64_t frames) {
+        if (!playback) return;
+        std::int64_t frame = static_cast<std::int64_t>(sim.get_frame()) + frames;
+        player->seek(static_cast<std::uint64_t>(std::max<std::int64_t>(frame, 0)));
+        // the stack jumps as if a new game began, so nothing is animated from the frame before
+        games++;
+        sim_time = clock.getElapsedTime();
+        publish();
+        request_hint();
+    }
+
+    void SimulationThread::process_input() {
+        InputEvent event;
+        while (input.pop(event)) {
+            switch (event.type) {
+            case InputEvent::Type::ACTION:
+                pending_actions.push_back(event);
+                break;
+            case InputEvent::Type::PAUSE:
+                paused = true;
+                break;
+            case InputEvent::Type::RESUME:
+                // the game does not advance for the time it was paused
+                paused = false;
+                sim_time = clock.getElapsedTime();
+                break;
+            case InputEvent::Type::RESET:
+                restart();
+                break;
+            case InputEvent::Type::AUTOPLAY:
+                autoplay = !autoplay;
+                autoplay_frames = 0;
+                break;
+            case InputEvent::Type::HINTS:
+                if (hints == nullptr) break;
+                hints->set_enabled(!hints->is_enabled());
+                request_hint();
+                break;
+            case InputEvent::Type::SEEK:
+                seek_playback(event.amount);
+                break;
+            case InputEvent::Type::PLAYBACK_SPEED:
+                if (event.amount > 0)
+                    playback_speed = std::min(std::max(playback_speed * 2, 1u), SimulationThread::max_playback_speed);
+                else if (event.amount < 0)
+                    playback_speed /= 2;
+                break;
+            case InputEvent::Type::STEP:
+                playback_speed = 0;
+                seek_playback(event.amount);
+                break;
+            }
+        }
+    }
+
+    void SimulationThread::step_simulation(sf::Time step_end) {
+        // every step takes exactly the input that arrived before it ended
+        auto step_input_end = std::find_if(pending_actions.begin(), pending_actions.end(),
+                                           [&] (const InputEvent &e) { return e.time >= step_end; });
+        step_actions.clear();
+        for (auto it = pending_actions.begin(); it != step_input_end; ++it)
+            step_actions.push_back(it->action);
+        pending_actions.erase(pending_actions.begin(), step_input_end);
+
+        if (playback) {
+            // only the recorded input counts, and the game stands still once the recording ends; when
+            // fast-forwarding, only the piece left in play after the last of the frames gets a hint
+            std::uint64_t locks_before = locks;
+            for (unsigned int i = 0; i < playback_speed && !player->finished(); i++) {
+                StepResult result = player->step();
+                if (result.lines_cleared > 0) line_clears++;
+                if (result.piece_locked) locks++;
+            }
+            if (locks != locks_before) request_hint();
+            return;
+        }
+
+        if (autoplay) {
+            // the whole path goes into one step, so gravity can't get in its way even at 20G
+            step_actions.clear();
+            if (sim.is_falling_piece_active() && ++autoplay_frames >= SimulationThread::autoplay_piece_frames) {
+                const std::vector<Action> &path = bot.choose(sim.get_board(), sim.get_falling_piece(),
+                                                             sim.get_next_piece(), sim.get_falling_piece_pos());
+                step_actions.assign(path.begin(), path.end());
+                autoplay_frames = 0;
+            }
+        }
+
+        if (recording_game) {
+            for (Action action : step_actions)
+                recording.add(sim.get_frame(), action);
+        }
+        StepResult result = sim.step(step_actions);
+        if (recording_game && sim.get_frame() % (rules.frame_rate * SimulationThread::checkpoint_seconds) == 0)
+            recording.add_checkpoint(sim.checkpoint());
+        if (sim.is_game_over()) end_recording();
+        if (result.lines_cleared > 0) line_clears++;
+        if (result.piece_locked) {
+            // the next piece spawns in the same step, so the search on the old one is replaced right away
+            locks++;
+            request_hint();
+        }
+
+        // when the bot is playing for a soak test or a demo, a lost game just starts over
+        if (autoplay && sim.is_game_over())
+            restart();
+    }
+
+    void SimulationThread::run() {
+        const sf::Time step_period = sf::seconds(1.f) / static_cast<float>(rules.frame_rate);
+        while (running.load(std::memory_order_acquire)) {
+            process_input();
+
+            // advance the simulation in fixed steps, however long the last iteration took
+            sf::Time now = clock.getElapsedTime();
+            unsigned int steps = 0;
+            while (!paused && now - sim_time >= step_period) {
+                if (steps == SimulationThread::max_catch_up_steps) {
+                    // too far behind to catch up, the remaining whole steps are dropped
+                    sim_time = now - (now - sim_time) % step_period;
+                    break;
+                }
+                steps++;
+                sim_time += step_period;
+                step_simulation(sim_time);
+            }
+            if (steps > 0) publish();
+
+            // the recording goes to the writer thread in whole chunks, anything it can't take yet waits
+            if (recording.data().size() >= SimulationThread::recording_chunk_size)
+                flush_recording();
+            replay_writer.flush();
+
+            // sleep until the next step, but keep taking input often
+            sf::Time sleep_time = std::min(sim_time + step_period - clock.getElapsedTime(),
+                                           SimulationThread::input_poll_period);
+            if (sleep_time > sf::Time::Zero)
+                sf::sleep(sleep_time);
+        }
+    }
+}
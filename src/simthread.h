@@ -0,0 +1,153 @@
+#ifndef SIMTHREAD_H_
+#define SIMTHREAD_H_
+#include "bot.h"
+#include "hint.h"
+#include "lockfree.h"
+#include "replay.h"
+#include "replaywriter.h"
+#include "sim.h"
+#include "tetro.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <SFML/System.hpp>
+
+namespace tetriskl {
+    // struktūra FrameSnapshot ir spēles stāvokļa kopija, ko simulācijas pavediens nodod zīmēšanai
+    struct FrameSnapshot {
+        Simulation::Board board;
+        Tetromino falling_piece;
+        Tetromino next_piece;
+        sf::Vector2u falling_piece_pos;
+        sf::Vector2u landing_pos;
+        bool falling_piece_active;
+        bool game_over;
+        unsigned int score;
+        std::uint64_t frame;
+
+        // skaitītāji, kas mainās ar katru jaunu spēli, nofiksētu gabalu un rindu notīrīšanu
+        std::uint64_t games;
+        std::uint64_t locks;
+        std::uint64_t line_clears;
+
+        // pēdējā rindu notīrīšana: lauciņš pirms tās un notīrīto rindu numuri
+        Simulation::Board pre_clear_board;
+        std::array<unsigned int, Simulation::Board::rows> cleared_lines;
+        std::size_t num_cleared_lines;
+    };
+
+    // struktūra InputEvent ir viena ievade no zīmēšanas pavediena simulācijas pavedienam
+    struct InputEvent {
+        enum class Type {
+            ACTION,
+            PAUSE,
+            RESUME,
+            RESET,
+            // turns the bot that plays instead of the player on or off
+            AUTOPLAY,
+            // turns the placement hints on or off
+            HINTS,
+            // moves a replay being played back by amount frames
+            SEEK,
+            // doubles the playback speed when amount is positive and halves it when it is negative
+            PLAYBACK_SPEED,
+            // stops the playback and moves it by amount frames
+            STEP,
+        };
+
+        Type type;
+        sf::Time time;
+        Action action;
+        std::int64_t amount;
+    };
+
+    // Klase SimulationThread darbina Simulation savā pavedienā ar fiksētu soli. Ievade tiek saņemta caur
+    // SpscQueue, bet pēc katra soļa stāvoklis tiek publicēts caur TripleBuffer, tāpēc zīmēšana nekad
+    // neaiztur simulāciju un simulācija nekad negaida zīmēšanu. Katra spēle tiek ierakstīta caur ReplayWriter,
+    // vai arī, ja tā dota, ievades vietā tiek atkārtota ierakstītā spēle, kuru var paātrināt, apturēt un pārtīt
+    // abos virzienos.
+    class SimulationThread {
+    private:
+        Ruleset rules;
+        // the game being played back, or nullptr when the player plays
+        std::unique_ptr<Replay> playback;
+        sf::Clock clock;
+        SpscQueue<InputEvent, 256> input;
+        TripleBuffer<FrameSnapshot> snapshots;
+        std::atomic<bool> running;
+        std::thread thread;
+
+        // used only by the simulation thread once it is started
+        Simulation sim;
+        std::vector<InputEvent> pending_actions;
+        std::vector<Action> step_actions;
+        sf::Time sim_time;
+        bool paused;
+        std::uint64_t games;
+        std::uint64_t locks;
+        std::uint64_t line_clears;
+        Bot bot;
+        bool autoplay;
+        unsigned int autoplay_frames;
+        HintEngine *hints;
+        std::uint32_t seed;
+        ReplayEncoder recording;
+        ReplayWriter replay_writer;
+        std::unique_ptr<ReplayPlayer> player;
+        // recorded frames played in every step, 0 while the playback stands still
+        unsigned int playback_speed;
+        bool recording_game;
+
+        const static sf::Time input_poll_period;
+        constexpr static unsigned int max_catch_up_steps = 5;
+        // the bot places a piece once it has been in play this many frames, so it can still be watched
+        constexpr static unsigned int autoplay_piece_frames = 6;
+        constexpr static std::size_t recording_chunk_size = 256;
+        constexpr static unsigned int max_playback_speed = 64;
+        // a checkpoint goes into the recording every this many seconds of play
+        constexpr static unsigned int checkpoint_seconds = 30;
+
+        void run();
+        void begin_game();
+        void end_recording();
+        void flush_recording();
+        void restart();
+        void request_hint();
+        void seek_playback(std::int64_t frames);
+        void process_input();
+        void step_simulation(sf::Time step_end);
+        void publish();
+    public:
+        // konstruktors SimulationThread(rules, replay_directory, replay) sāk spēli ar noteikumiem rules un ieraksta
+        // katru spēli mapē replay_directory, ja tā nav tukša. Ja replay nav nullptr, tiek atkārtota ierakstītā spēle
+        // replay ar tās noteikumiem, neņemot vērā spēlētāja darbības un neko neierakstot.
+        explicit SimulationThread(const Ruleset &rules, const std::string &replay_directory = "",
+                                  const Replay *replay = nullptr);
+        ~SimulationThread();
+        SimulationThread(const SimulationThread&) = delete;
+        SimulationThread& operator=(const SimulationThread&) = delete;
+
+        // metode set_hint_engine(hints) liek simulācijai sūtīt katru jauno gabalu analīzei meklētājam hints;
+        // to drīkst izsaukt tikai pirms start()
+        void set_hint_engine(HintEngine *hints) { this->hints = hints; }
+
+        void start();
+        void stop();
+
+        // metode now() atgriež laiku, kurā abi pavedieni mēra ievades laika zīmogus
+        sf::Time now() const;
+        // metode send(event) nosūta ievadi simulācijai un atgriež false, ja rinda ir pilna
+        bool send(const InputEvent &event);
+        // metode update_snapshot() paņem jaunāko publicēto stāvokli un atgriež true, ja tas ir jauns
+        bool update_snapshot();
+        const FrameSnapshot& get_snapshot() const;
+    };
+}
+
+#endif // SIMTHREAD_H_
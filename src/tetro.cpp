@@ -1,7 +1,7 @@
 #include "tetro.h"
 #include <algorithm>
+#include <random>
 #include <stdexcept>
-#include <SFML/Graphics.hpp>
 
 namespace tetriskl {
     bool CellGrid::can_place(sf::Vector2u pos, const CellGrid &tile) const {
@@ -31,51 +31,14 @@ namespace tetriskl {
         }
     }
 
-    ConstGridView::ConstGridView(const CellGrid& _inner, sf::Vector2u _top_left, sf::Vector2u _bottom_right)
-        : inner(_inner), top_left(_top_left), bottom_right(_bottom_right) {}
-
-    Cell& ConstGridView::operator[](sf::Vector2u point) {
-        throw std::logic_error("cannot use non-const operator[] with ConstGridView");
-    }
-
-    const Cell& ConstGridView::operator[](sf::Vector2u point) const {
-        return inner[top_left + point];
-    }
-
-    sf::Vector2u ConstGridView::size() const {
-        return bottom_right - top_left;
-    }
-
-    Tetromino::Tetromino() : grid(), unrot_size(sf::Vector2u(0, 0)), rot(Rotation::NONE), rot_origin(), rotates(false) {}
-    Tetromino::Tetromino(init_list<init_list<Cell>> cg) : grid(cg), rot(Rotation::NONE), rot_origin(), rotates(false) {
-        unrot_size.y = cg.size();
-        unrot_size.x = std::max(cg, [] (auto &a, auto &b) { return a.size() < b.size(); }).size();
-    }
-
-
-    sf::Vector2u unrotate_point(Rotation rot, sf::Vector2u p, sf::Vector2u size) {
-        sf::Vector2u origin = size;
-        switch (rot) {
-        case Rotation::NONE: return p;
-        case Rotation::DEG90: return sf::Vector2u(size.x - 1 - p.y, p.x);
-        case Rotation::DEG180: return sf::Vector2u(size.x - 1 - p.x, size.y - 1 -  p.y);
-        case Rotation::DEG270: return sf::Vector2u(p.y, size.y -1 - p.x);
-        }
-        throw std::logic_error("Rotation invariant violation");
-    }
-
-    sf::Vector2u rotate_point(Rotation rot, sf::Vector2u p, sf::Vector2u size) {
-        sf::Vector2u origin = size;
-        switch (rot) {
-        case Rotation::NONE: return p;
-        case Rotation::DEG90: return sf::Vector2u(p.y, size.x - 1 - p.x);
-        case Rotation::DEG180: return sf::Vector2u(size.x - 1 - p.x, size.y - 1 -  p.y);
-        case Rotation::DEG270: return sf::Vector2u(size.y - 1 - p.y, p.x);
-        }
-        throw std::logic_error("Rotation invariant violation");
-    }
-
+    constexpr TetrominoStateTable Tetromino::state_table;
+    const array<Cell, NUM_CELLS> Tetromino::cell_values = {
+        Cell::I, Cell::J, Cell::L, Cell::O, Cell::S, Cell::Z, Cell::T, Cell::N
+    };
 
+    Tetromino::Tetromino() : kind(Cell::N), rot(Rotation::NONE) {}
+    Tetromino::Tetromino(Cell kind) : kind(kind), rot(Rotation::NONE) {}
+    Tetromino::Tetromino(Cell kind, Rotation rot) : kind(kind), rot(rot) {}
 
     Rotation invert_rotation(Rotation rot) {
         return (rot != Rotation::NONE)
@@ -83,148 +46,184 @@ namespace tetriskl {
             : rot;
     }
 
-    Cell& Tetromino::operator[](sf::Vector2u point) {
-        return grid[unrotate_point(rot, point, unrot_size)];
-    }
+    static const char *const randomizer_names[NUM_RANDOMIZERS] = {
+        "7bag", "14bag", "memoryless", "tgm", "legacy",
+    };
 
-    const Cell& Tetromino::operator[](sf::Vector2u point) const {
-        return grid[unrotate_point(rot, point, unrot_size)];
+    const char* randomizer_name(Randomizer randomizer) {
+        return randomizer_names[static_cast<int>(randomizer)];
     }
 
-
-    sf::Vector2u Tetromino::size() const {
-        switch (rot) {
-        case Rotation::NONE: case Rotation::DEG180: return unrot_size;
-        case Rotation::DEG90: case Rotation::DEG270: return sf::Vector2u(unrot_size.y, unrot_size.x);
+    bool parse_randomizer(const std::string &name, Randomizer &randomizer) {
+        for (int r = 0; r < NUM_RANDOMIZERS; r++) {
+            if (name != randomizer_names[r]) continue;
+            randomizer = static_cast<Randomizer>(r);
+            return true;
         }
-        throw std::logic_error("Rotation invariant violation");
-    }
-
-    void Tetromino::set_origin(sf::Vector2u origin) {
-        this->rot_origin = origin;
-        rotates = true;
-    }
-
-    void Tetromino::rotate_to(CellGrid &grid, sf::Vector2u &pos, Rotation new_rot) {
-        if (!rotates) return;
-        Rotation old_rot = rot;
-        sf::Vector2u old_pos = pos;
-        for (const sf::Vector2i wall_kick : {sf::Vector2i(0, 0), sf::Vector2i(1, 0), sf::Vector2i(-1, 0)}) {
-            sf::Vector2u rotated_origin_pre = rotate_point(rot, rot_origin, unrot_size);
-            rot = new_rot;
-            sf::Vector2u rotated_origin_post = rotate_point(rot, rot_origin, unrot_size);
-            sf::Vector2i new_pos = sf::Vector2i(pos + rotated_origin_pre - rotated_origin_post) + wall_kick;
-
-            if (new_pos.x < 0 || new_pos.y < 0 || !grid.can_place(sf::Vector2u(new_pos), *this)) {
-                rot = old_rot;
-                pos = old_pos;
-                continue;
+        return false;
+    }
+
+    namespace {
+        // counts the outputs std::shuffle takes, so the legacy generator can be rebuilt from its seed
+        class CountingMt19937 {
+        private:
+            std::mt19937 &rng;
+            std::uint64_t &draws;
+        public:
+            using result_type = std::mt19937::result_type;
+            CountingMt19937(std::mt19937 &rng, std::uint64_t &draws) : rng(rng), draws(draws) {}
+            static constexpr result_type min() { return std::mt19937::min(); }
+            static constexpr result_type max() { return std::mt19937::max(); }
+            result_type operator()() {
+                draws++;
+                return rng();
             }
-
-            pos = sf::Vector2u(new_pos);
-            break;
-        }
+        };
     }
 
-    void Tetromino::rotate_ccw(CellGrid &grid, sf::Vector2u &pos) {
-        Rotation new_rot = (Rotation) (((int) rot + 1) % NUM_ROTATIONS);
-        rotate_to(grid, pos, new_rot);
-    }
+    struct TetrominoProvider::LegacyGenerator {
+        std::mt19937 rng;
+        std::uint64_t draws;
+    };
+
+    void TetrominoProvider::legacy_reshuffle() {
+        // The generator is only built when a bag is first needed and then kept, shared between copies until one
+        // of them draws from it. It is rebuilt from the seed only when the state was set back before it, or set
+        // to another seed.
+        if (!legacy_rng || legacy_rng->draws > legacy_draws)
+            legacy_rng = std::make_shared<LegacyGenerator>(LegacyGenerator{std::mt19937(legacy_seed), 0});
+        else if (legacy_rng.use_count() > 1)
+            legacy_rng = std::make_shared<LegacyGenerator>(*legacy_rng);
+        legacy_rng->rng.discard(legacy_draws - legacy_rng->draws);
 
-    void Tetromino::rotate_cw(CellGrid &grid, sf::Vector2u &pos) {
-        Rotation new_rot = (rot == Rotation::NONE)
-            ? Rotation::DEG270
-            : (Rotation)((int)rot - 1);
-        rotate_to(grid, pos, new_rot);
+        CountingMt19937 counting(legacy_rng->rng, legacy_draws);
+        // like before, every bag is a shuffle of the previous one
+        std::shuffle(pool.begin(), pool.begin() + NUM_TETROMINOES, counting);
+        legacy_rng->draws = legacy_draws;
     }
 
     void TetrominoProvider::reshuffle() {
-        std::shuffle(tetromino_bag.begin(), tetromino_bag.end(), rng);
         i = 0;
+        if (randomizer == Randomizer::LEGACY_BAG_7) {
+            legacy_reshuffle();
+            return;
+        }
+        for (std::size_t k = 0; k < size; k++)
+            pool[k] = static_cast<Cell>(k % NUM_TETROMINOES);
+        // Fisher-Yates with our own bounded draws, so the order doesn't depend on the standard library
+        for (std::size_t k = size - 1; k > 0; k--)
+            std::swap(pool[k], pool[rng.bounded(k + 1)]);
+    }
+
+    Cell TetrominoProvider::draw_history() {
+        Cell kind = Cell::N;
+        if (i == 0) {
+            // the first piece is never one that can leave an overhang on the empty board
+            static const Cell first_kinds[] = {Cell::I, Cell::J, Cell::L, Cell::T};
+            kind = first_kinds[rng.bounded(4)];
+            i = 1;
+        } else {
+            for (unsigned int roll = 0; roll < history_rolls; roll++) {
+                kind = static_cast<Cell>(rng.bounded(NUM_TETROMINOES));
+                if (std::find(pool.begin(), pool.begin() + history_size, kind) == pool.begin() + history_size) break;
+            }
+        }
+        std::copy_backward(pool.begin(), pool.begin() + history_size - 1, pool.begin() + history_size);
+        pool[0] = kind;
+        return kind;
+    }
+
+    TetrominoProvider::TetrominoProvider() : TetrominoProvider(std::random_device()()) {}
+
+    TetrominoProvider::TetrominoProvider(std::uint32_t seed, Randomizer randomizer)
+        : randomizer(randomizer),
+          // every seed gets a stream of its own, so no two games share a sequence even shifted
+          rng(seed, seed),
+          legacy_seed(seed),
+          legacy_draws(0),
+          legacy_rng(),
+          pool(),
+          size(0),
+          i(0) {
+        // the history starts out as if four Z pieces had come, and the legacy bag as all of them in order
+        pool.fill(Cell::Z);
+        switch (randomizer) {
+        case Randomizer::BAG_7:
+            size = NUM_TETROMINOES;
+            break;
+        case Randomizer::LEGACY_BAG_7:
+            size = NUM_TETROMINOES;
+            for (int k = 0; k < NUM_TETROMINOES; k++)
+                pool[k] = static_cast<Cell>(k);
+            break;
+        case Randomizer::BAG_14:
+            size = 2 * NUM_TETROMINOES;
+            break;
+        case Randomizer::MEMORYLESS:
+            break;
+        case Randomizer::TGM_HISTORY:
+            size = history_size;
+            break;
+        }
+        if (randomizer != Randomizer::MEMORYLESS && randomizer != Randomizer::TGM_HISTORY) reshuffle();
     }
 
-    TetrominoProvider::TetrominoProvider() : tetromino_bag(tetrominoes), i(0) {
-        std::random_device rd;
-        rng = std::mt19937(rd());
-        reshuffle();
+    Tetromino TetrominoProvider::next() {
+        switch (randomizer) {
+        case Randomizer::MEMORYLESS:
+            return Tetromino(static_cast<Cell>(rng.bounded(NUM_TETROMINOES)));
+        case Randomizer::TGM_HISTORY:
+            return Tetromino(draw_history());
+        default:
+            if (i >= size) reshuffle();
+            return Tetromino(pool[i++]);
+        }
     }
 
+    std::uint8_t TetrominoProvider::bag_mask() const {
+        if (randomizer == Randomizer::MEMORYLESS || randomizer == Randomizer::TGM_HISTORY)
+            return (1 << NUM_TETROMINOES) - 1;
+        std::uint8_t mask = 0;
+        for (std::size_t j = i; j < size; j++)
+            mask |= 1 << (int)pool[j];
+        return mask;
+    }
 
-    Tetromino TetrominoProvider::next() {
-        if (i >= tetromino_bag.size()) reshuffle();
-        return tetromino_bag[i++];
+    TetrominoProvider::State TetrominoProvider::get_state() const {
+        State state{};
+        if (randomizer == Randomizer::LEGACY_BAG_7) {
+            state.rng_state = legacy_draws;
+            state.rng_increment = legacy_seed;
+        } else {
+            state.rng_state = rng.get_state();
+            state.rng_increment = rng.get_increment();
+        }
+        state.pool = pool;
+        state.size = size;
+        state.next = i;
+        return state;
+    }
+
+    void TetrominoProvider::set_state(const State &state) {
+        if (randomizer == Randomizer::LEGACY_BAG_7) {
+            legacy_draws = state.rng_state;
+            std::uint32_t seed = static_cast<std::uint32_t>(state.rng_increment);
+            if (seed != legacy_seed) legacy_rng.reset();
+            legacy_seed = seed;
+        } else {
+            rng = Pcg32::from_state(state.rng_state, state.rng_increment);
+        }
+        pool = state.pool;
+        size = state.size;
+        i = state.next;
     }
 
     array<Tetromino, NUM_TETROMINOES> make_tetromino_tbl() {
-        constexpr Cell I = Cell::I;
-        constexpr Cell J = Cell::J;
-        constexpr Cell L = Cell::L;
-        constexpr Cell O = Cell::O;
-        constexpr Cell S = Cell::S;
-        constexpr Cell Z = Cell::Z;
-        constexpr Cell T = Cell::T;
-        constexpr Cell N = Cell::N;
-
         array<Tetromino, NUM_TETROMINOES> tbl;
-        tbl[(int)I] = {
-            {I, I, I, I},
-        };
-        tbl[(int)I].set_origin(sf::Vector2u(1, 0));
-
-        tbl[(int)J] = {
-            {J, N, N},
-            {J, J, J},
-        };
-        tbl[(int)J].set_origin(sf::Vector2u(1, 1));
-
-        tbl[(int)L] = {
-            {N, N, L},
-            {L, L, L},
-        };
-        tbl[(int)L].set_origin(sf::Vector2u(1, 1));
-
-        tbl[(int)O] = {
-            {O, O},
-            {O, O}
-        };
-
-        tbl[(int)S] = {
-            {N, S, S},
-            {S, S, N},
-        };
-        tbl[(int)S].set_origin(sf::Vector2u(1, 1));
-
-        tbl[(int)Z] = {
-            {Z, Z, N},
-            {N, Z, Z},
-        };
-        tbl[(int)Z].set_origin(sf::Vector2u(1, 1));
-
-        tbl[(int)T] = {
-            {N, T, N},
-            {T, T, T}
-        };
-        tbl[(int)T].set_origin(sf::Vector2u(1, 1));
+        for (int i = 0; i < NUM_TETROMINOES; i++)
+            tbl[i] = Tetromino(static_cast<Cell>(i));
         return tbl;
     }
 
     const array<Tetromino, NUM_TETROMINOES> tetrominoes = make_tetromino_tbl();
-
-
-    array<sf::Color, NUM_CELLS> make_color_tbl() {
-        array<sf::Color, NUM_CELLS> retval;
-
-        retval[(int)Cell::I] = sf::Color(0x34dbebff);
-        retval[(int)Cell::J] = sf::Color(0x083673ff);
-        retval[(int)Cell::L] = sf::Color(0xeb8100ff);
-        retval[(int)Cell::O] = sf::Color(0xffdd00ff);
-        retval[(int)Cell::S] = sf::Color(0x098700ff);
-        retval[(int)Cell::Z] = sf::Color(0xcc2c00ff);
-        retval[(int)Cell::T] = sf::Color(0x969696ff);
-        retval[(int)Cell::N] = sf::Color(0x00000000);
-        return retval;
-    }
-
-    const sf::Color outline_color = sf::Color(0x6e6e6eff);
-    const array<sf::Color, NUM_CELLS> cell_colors = make_color_tbl();
 }
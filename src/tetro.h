@@ -1,12 +1,15 @@
 #ifndef TETRO_H_
 #define TETRO_H_
+#include "pcg.h"
+
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <SFML/System.hpp>
-#include <SFML/Graphics.hpp>
 #include <stdexcept>
 #include <cstdint>
-#include <random>
+#include <memory>
+#include <string>
 #include <vector>
 
 namespace tetriskl {
@@ -32,9 +35,9 @@ namespace tetriskl {
     constexpr int NUM_ROTATIONS = 4;
 
     // Abstraktā klase CellGrid attēlo jebkādu lauciņu ar Cell tipa šūnām
-    class CellGrid : public sf::Drawable {
+    class CellGrid {
     public:
-        void draw(sf::RenderTarget &target, sf::RenderStates states) const override;
+        virtual ~CellGrid() = default;
         // metode can_place(pos, tile) pārbauda, vai lauciņa tile saturu var novietot vietā pos.
         bool can_place(sf::Vector2u pos, const CellGrid &tile) const;
         // metode place(pos, tile) novieto lauciņua tile saturu vietā pos
@@ -46,8 +49,29 @@ namespace tetriskl {
         virtual sf::Vector2u size() const = 0;
     };
 
+    class Tetromino;
+
+    // Klase GridBase<Derived> ir CellGrid statiskā (CRTP) versija: tās metodes piekļūst šūnām caur
+    // konkrēto tipu Derived, tāpēc izsaukumi nenotiek caur vtable un kompilators tos var iekļaut.
+    // Dinamisko CellGrid saskarni izmanto tikai tur, kur lauciņu tipi patiešām ir dažādi.
+    template <typename Derived>
+    class GridBase: public CellGrid {
+    private:
+        const Derived& self() const { return static_cast<const Derived&>(*this); }
+        Derived& self() { return static_cast<Derived&>(*this); }
+    public:
+        // metode can_place(pos, tile) pārbauda, vai lauciņa tile saturu var novietot vietā pos.
+        template <typename Tile>
+        bool can_place(sf::Vector2u pos, const Tile &tile) const;
+        bool can_place(sf::Vector2u pos, const Tetromino &piece) const;
+        // metode place(pos, tile) novieto lauciņa tile saturu vietā pos
+        template <typename Tile>
+        void place(sf::Vector2u pos, const Tile &tile);
+        void place(sf::Vector2u pos, const Tetromino &piece);
+    };
+
     template<std::size_t Columns, std::size_t Rows>
-    class StaticCellGrid: public CellGrid {
+    class StaticCellGrid final: public GridBase<StaticCellGrid<Columns, Rows>> {
     private:
         array<array<Cell, Columns>, Rows> cells;
 
@@ -110,60 +134,509 @@ namespace tetriskl {
 
     };
 
-    class ConstGridView: public CellGrid {
+    // klase ConstGridView<Grid> attēlo taisnstūrveida daļu no lauciņa inner bez iespējas to mainīt
+    template <typename Grid>
+    class ConstGridView final: public GridBase<ConstGridView<Grid>> {
     private:
-        const CellGrid& inner;
+        const Grid& inner;
         sf::Vector2u top_left;
         sf::Vector2u bottom_right;
     public:
         ConstGridView() = delete;
-        ConstGridView(const CellGrid& _inner, sf::Vector2u _top_left, sf::Vector2u _bottom_right);
+        ConstGridView(const Grid& _inner, sf::Vector2u _top_left, sf::Vector2u _bottom_right)
+            : inner(_inner), top_left(_top_left), bottom_right(_bottom_right) {}
+
+        Cell& operator[](sf::Vector2u) override {
+            throw std::logic_error("cannot use non-const operator[] with ConstGridView");
+        }
+
+        const Cell& operator[](sf::Vector2u point) const override {
+            return inner[top_left + point];
+        }
+
+        sf::Vector2u size() const override {
+            return bottom_right - top_left;
+        }
+    };
+
+    // funkcija const_grid_view(inner, top_left, bottom_right) izveido ConstGridView konkrētajam lauciņa tipam
+    template <typename Grid>
+    ConstGridView<Grid> const_grid_view(const Grid& inner, sf::Vector2u top_left, sf::Vector2u bottom_right) {
+        return ConstGridView<Grid>(inner, top_left, bottom_right);
+    }
+
+    // struktūra TilePoint attēlo šūnas koordinātas tetramino rotācijas stāvoklī
+    struct TilePoint {
+        unsigned int x;
+        unsigned int y;
+    };
+
+    constexpr unsigned int TETROMINO_CELLS = 4;
+
+    // struktūra TetrominoShape apraksta tetramino nerotēto formu: izmērus, rindu maskas
+    // (bits x atbilst kolonnai x) un SRS rotācijas kvadrātu, kurā tas rotē: tā izmēru un rindu,
+    // kurā atrodas nerotētā forma
+    struct TetrominoShape {
+        unsigned int width;
+        unsigned int height;
+        std::uint8_t rows[TETROMINO_CELLS];
+        bool rotates;
+        unsigned int box_size;
+        unsigned int box_row;
+    };
+
+    // struktūra TetrominoState apraksta vienu tetramino rotācijas stāvokli: izmērus, aizņemtās šūnas,
+    // rindu maskas, katras kolonnas zemāko aizņemto rindu un stāvokļa atrašanās vietu rotācijas kvadrātā
+    struct TetrominoState {
+        unsigned int width;
+        unsigned int height;
+        TilePoint cells[TETROMINO_CELLS];
+        std::uint8_t rows[TETROMINO_CELLS];
+        std::uint8_t column_bottom[TETROMINO_CELLS];
+        TilePoint box_offset;
+    };
+
+    // struktūra KickOffset ir viens pozīcijas pārvietojums, ar kuru mēģina novietot pagriezto tetramino
+    struct KickOffset {
+        int x;
+        int y;
+    };
+
+    constexpr unsigned int MAX_KICKS = 6;
+
+    // struktūra TetrominoStateTable satur visu tetramino visus rotācijas stāvokļus un katrai pārejai
+    // starp tiem pozīcijas pārvietojumus, kas jāizmēģina pēc kārtas (jau ietverot pārvietojumu
+    // rotācijas kvadrātā, tāpēc pirmais pārvietojums ir pats pagrieziens bez atsitiena)
+    struct TetrominoStateTable {
+        bool rotates[NUM_CELLS];
+        TetrominoState states[NUM_CELLS][NUM_ROTATIONS];
+        unsigned int num_kicks[NUM_CELLS][NUM_ROTATIONS][NUM_ROTATIONS];
+        KickOffset kicks[NUM_CELLS][NUM_ROTATIONS][NUM_ROTATIONS][MAX_KICKS];
+    };
+
+    constexpr std::uint8_t make_row_mask(init_list<Cell> row) {
+        std::uint8_t mask = 0;
+        unsigned int x = 0;
+        for (Cell c : row) {
+            if (c != Cell::N)
+                mask |= 1u << x;
+            x++;
+        }
+        return mask;
+    }
+
+    constexpr TetrominoShape make_tetromino_shape(init_list<init_list<Cell>> cells, bool rotates = false,
+                                                  unsigned int box_size = 0, unsigned int box_row = 0) {
+        TetrominoShape shape{};
+        shape.height = cells.size();
+        shape.rotates = rotates;
+        shape.box_size = box_size;
+        shape.box_row = box_row;
+        unsigned int y = 0;
+        for (init_list<Cell> row : cells) {
+            if (row.size() > shape.width)
+                shape.width = row.size();
+            shape.rows[y++] = make_row_mask(row);
+        }
+        return shape;
+    }
+
+    constexpr TetrominoShape tetromino_shape(Cell kind) {
+        constexpr Cell I = Cell::I;
+        constexpr Cell J = Cell::J;
+        constexpr Cell L = Cell::L;
+        constexpr Cell O = Cell::O;
+        constexpr Cell S = Cell::S;
+        constexpr Cell Z = Cell::Z;
+        constexpr Cell T = Cell::T;
+        constexpr Cell N = Cell::N;
+
+        switch (kind) {
+        case Cell::I: return make_tetromino_shape({
+                {I, I, I, I},
+            }, true, 4, 1);
+        case Cell::J: return make_tetromino_shape({
+                {J, N, N},
+                {J, J, J},
+            }, true, 3, 0);
+        case Cell::L: return make_tetromino_shape({
+                {N, N, L},
+                {L, L, L},
+            }, true, 3, 0);
+        case Cell::O: return make_tetromino_shape({
+                {O, O},
+                {O, O},
+            });
+        case Cell::S: return make_tetromino_shape({
+                {N, S, S},
+                {S, S, N},
+            }, true, 3, 0);
+        case Cell::Z: return make_tetromino_shape({
+                {Z, Z, N},
+                {N, Z, Z},
+            }, true, 3, 0);
+        case Cell::T: return make_tetromino_shape({
+                {N, T, N},
+                {T, T, T},
+            }, true, 3, 0);
+        case Cell::N: break;
+        }
+        return TetrominoShape{};
+    }
+
+    // funkcija unrotate_point(rot, p, size) pārvērš punktu p rotētajā stāvoklī par punktu nerotētajā formā
+    constexpr TilePoint unrotate_point(Rotation rot, TilePoint p, TilePoint size) {
+        switch (rot) {
+        case Rotation::NONE: return p;
+        case Rotation::DEG90: return TilePoint{size.x - 1 - p.y, p.x};
+        case Rotation::DEG180: return TilePoint{size.x - 1 - p.x, size.y - 1 - p.y};
+        case Rotation::DEG270: return TilePoint{p.y, size.y - 1 - p.x};
+        }
+        return p;
+    }
+
+    // funkcija rotate_point(rot, p, size) pārvērš punktu p nerotētajā formā par punktu rotētajā stāvoklī
+    constexpr TilePoint rotate_point(Rotation rot, TilePoint p, TilePoint size) {
+        switch (rot) {
+        case Rotation::NONE: return p;
+        case Rotation::DEG90: return TilePoint{p.y, size.x - 1 - p.x};
+        case Rotation::DEG180: return TilePoint{size.x - 1 - p.x, size.y - 1 - p.y};
+        case Rotation::DEG270: return TilePoint{size.y - 1 - p.y, p.x};
+        }
+        return p;
+    }
+
+    constexpr TetrominoState make_tetromino_state(const TetrominoShape &shape, Rotation rot) {
+        TetrominoState state{};
+        TilePoint unrot_size{shape.width, shape.height};
+        bool swapped = rot == Rotation::DEG90 || rot == Rotation::DEG270;
+        state.width = swapped ? shape.height : shape.width;
+        state.height = swapped ? shape.width : shape.height;
+
+        // the shape and its rotation box turn together, so the box corner that lands on the state's top left
+        // gives where the state lies in the box
+        if (shape.rotates) {
+            TilePoint box_size{shape.box_size, shape.box_size};
+            TilePoint shape_corner = rotate_point(rot, TilePoint{0, shape.box_row}, box_size);
+            TilePoint shape_far_corner = rotate_point(rot, TilePoint{shape.width - 1, shape.box_row + shape.height - 1},
+                                                      box_size);
+            state.box_offset = TilePoint{std::min(shape_corner.x, shape_far_corner.x),
+                                         std::min(shape_corner.y, shape_far_corner.y)};
+        }
 
-        Cell& operator[](sf::Vector2u point) override;
-        const Cell& operator[](sf::Vector2u point) const override;
+        unsigned int num_cells = 0;
+        for (unsigned int y = 0; y < state.height; y++) {
+            for (unsigned int x = 0; x < state.width; x++) {
+                TilePoint unrot = unrotate_point(rot, TilePoint{x, y}, unrot_size);
+                if (!((shape.rows[unrot.y] >> unrot.x) & 1u)) continue;
+                state.rows[y] |= 1u << x;
+                state.column_bottom[x] = y;
+                state.cells[num_cells++] = TilePoint{x, y};
+            }
+        }
+        return state;
+    }
 
-        sf::Vector2u size() const override;
+    // SRS stāvokļi 0, R, 2 un L pēc kārtas; R ir pagrieziens pulksteņrādītāja virzienā
+    constexpr Rotation srs_rotations[NUM_ROTATIONS] = {
+        Rotation::NONE, Rotation::DEG270, Rotation::DEG180, Rotation::DEG90
     };
 
+    constexpr unsigned int SRS_TESTS = 5;
+
+    // funkcija srs_offset(kind, state, test) atgriež SRS nobīdi test stāvoklim state (0, R, 2, L), ar y uz augšu.
+    // Pārejas atsitieni ir sākuma un beigu stāvokļu nobīžu starpība.
+    constexpr KickOffset srs_offset(Cell kind, unsigned int state, unsigned int test) {
+        const KickOffset jlstz_offsets[NUM_ROTATIONS][SRS_TESTS] = {
+            {{0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}},
+            {{0, 0}, {1, 0}, {1, -1}, {0, 2}, {1, 2}},
+            {{0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}},
+            {{0, 0}, {-1, 0}, {-1, -1}, {0, 2}, {-1, 2}},
+        };
+        const KickOffset i_offsets[NUM_ROTATIONS][SRS_TESTS] = {
+            {{0, 0}, {-1, 0}, {2, 0}, {-1, 0}, {2, 0}},
+            {{-1, 0}, {0, 0}, {0, 0}, {0, 1}, {0, -2}},
+            {{-1, 1}, {1, 1}, {-2, 1}, {1, 0}, {-2, 0}},
+            {{0, 1}, {0, 1}, {0, 1}, {0, -1}, {0, 2}},
+        };
+        return kind == Cell::I ? i_offsets[state][test] : jlstz_offsets[state][test];
+    }
+
+    // funkcija srs_half_turn_kick(state, test) atgriež atsitienu pagriezienam par 180° no stāvokļa state, ar y uz augšu.
+    // SRS tos nedefinē, tāpēc tiek izmantota plaši pieņemtā SRS+ tabula visiem tetramino.
+    constexpr KickOffset srs_half_turn_kick(unsigned int state, unsigned int test) {
+        const KickOffset kicks[NUM_ROTATIONS][MAX_KICKS] = {
+            {{0, 0}, {0, 1}, {1, 1}, {-1, 1}, {1, 0}, {-1, 0}},
+            {{0, 0}, {1, 0}, {1, 2}, {1, 1}, {0, 2}, {0, 1}},
+            {{0, 0}, {0, -1}, {-1, -1}, {1, -1}, {-1, 0}, {1, 0}},
+            {{0, 0}, {-1, 0}, {-1, 2}, {-1, 1}, {0, 2}, {0, 1}},
+        };
+        return kicks[state][test];
+    }
+
+    constexpr TetrominoStateTable make_tetromino_state_table() {
+        TetrominoStateTable tbl{};
+        for (int kind = 0; kind < NUM_CELLS; kind++) {
+            TetrominoShape shape = tetromino_shape(static_cast<Cell>(kind));
+            tbl.rotates[kind] = shape.rotates;
+            for (int rot = 0; rot < NUM_ROTATIONS; rot++)
+                tbl.states[kind][rot] = make_tetromino_state(shape, static_cast<Rotation>(rot));
+            if (!shape.rotates) continue;
+
+            for (unsigned int from = 0; from < NUM_ROTATIONS; from++) {
+                for (unsigned int to = 0; to < NUM_ROTATIONS; to++) {
+                    if (from == to) continue;
+                    const int from_rot = (int)srs_rotations[from];
+                    const int to_rot = (int)srs_rotations[to];
+                    const TilePoint from_box = tbl.states[kind][from_rot].box_offset;
+                    const TilePoint to_box = tbl.states[kind][to_rot].box_offset;
+                    const bool half_turn = (from + 2) % NUM_ROTATIONS == to;
+                    const unsigned int num_tests = half_turn ? MAX_KICKS : SRS_TESTS;
+                    const KickOffset base{srs_offset(static_cast<Cell>(kind), from, 0).x
+                                          - srs_offset(static_cast<Cell>(kind), to, 0).x,
+                                          srs_offset(static_cast<Cell>(kind), from, 0).y
+                                          - srs_offset(static_cast<Cell>(kind), to, 0).y};
+
+                    tbl.num_kicks[kind][from_rot][to_rot] = num_tests;
+                    for (unsigned int test = 0; test < num_tests; test++) {
+                        KickOffset kick = srs_half_turn_kick(from, test);
+                        if (!half_turn) {
+                            // the first offset pair only recentres the I in its box, which the box offsets already do
+                            KickOffset from_offset = srs_offset(static_cast<Cell>(kind), from, test);
+                            KickOffset to_offset = srs_offset(static_cast<Cell>(kind), to, test);
+                            kick = KickOffset{from_offset.x - to_offset.x - base.x,
+                                              from_offset.y - to_offset.y - base.y};
+                        }
+                        // kicks point up, the board's rows grow downwards
+                        tbl.kicks[kind][from_rot][to_rot][test] = KickOffset{
+                            (int)to_box.x - (int)from_box.x + kick.x,
+                            (int)to_box.y - (int)from_box.y - kick.y,
+                        };
+                    }
+                }
+            }
+        }
+        return tbl;
+    }
 
-    class Tetromino: public CellGrid {
+    // klase Tetromino attēlo vienu tetramino noteiktā rotācijas stāvoklī. Visi stāvokļi tiek
+    // aprēķināti kompilācijas laikā tabulā state_table, tāpēc rotācija ir tikai indeksa maiņa.
+    class Tetromino final: public GridBase<Tetromino> {
     private:
-        StaticCellGrid<4, 4> grid;
-        sf::Vector2u unrot_size;
-        sf::Vector2u rot_origin;
+        Cell kind;
         Rotation rot;
-        bool rotates;
+        static const array<Cell, NUM_CELLS> cell_values;
 
-        void rotate_to(CellGrid &grid, sf::Vector2u &pos, Rotation new_rot);
+        template <typename Grid>
+        bool rotate_to(const Grid &grid, sf::Vector2u &pos, Rotation new_rot);
     public:
+        static constexpr TetrominoStateTable state_table = make_tetromino_state_table();
+
         Tetromino();
-        Tetromino(init_list<init_list<Cell>>);
+        explicit Tetromino(Cell kind);
+        Tetromino(Cell kind, Rotation rot);
+
+        Cell& operator[](sf::Vector2u) override {
+            throw std::logic_error("cannot use non-const operator[] with Tetromino");
+        }
 
-        Cell& operator[](sf::Vector2u point) override;
-        const Cell& operator[](sf::Vector2u point) const override;
-        sf::Vector2u size() const override;
+        const Cell& operator[](sf::Vector2u point) const override {
+            bool occupied = (state().rows[point.y] >> point.x) & 1u;
+            return cell_values[occupied ? (int)kind : (int)Cell::N];
+        }
 
-        void set_origin(sf::Vector2u origin);
-        void rotate_ccw(CellGrid &grid, sf::Vector2u &pos);
-        void rotate_cw(CellGrid &grid, sf::Vector2u &pos);
+        sf::Vector2u size() const override {
+            return sf::Vector2u(state().width, state().height);
+        }
+
+        // metode type() atgriež tetramino veidu
+        Cell type() const { return kind; }
+        // metode rotation() atgriež pašreizējo rotācijas stāvokli
+        Rotation rotation() const { return rot; }
+        // metode state() atgriež pašreizējā rotācijas stāvokļa aprakstu
+        const TetrominoState& state() const {
+            return state_table.states[(int)kind][(int)rot];
+        }
+
+        // metodes rotate_ccw(grid, pos), rotate_cw(grid, pos) un rotate_180(grid, pos) pagriež tetramino pēc SRS,
+        // ja to ļauj lauciņš grid, atbilstoši pārvietojot tā pozīciju pos, un atgriež, vai pagrieziens izdevās
+        template <typename Grid>
+        bool rotate_ccw(const Grid &grid, sf::Vector2u &pos) {
+            Rotation new_rot = (Rotation) (((int) rot + 1) % NUM_ROTATIONS);
+            return rotate_to(grid, pos, new_rot);
+        }
+
+        template <typename Grid>
+        bool rotate_cw(const Grid &grid, sf::Vector2u &pos) {
+            Rotation new_rot = (rot == Rotation::NONE)
+                ? Rotation::DEG270
+                : (Rotation)((int)rot - 1);
+            return rotate_to(grid, pos, new_rot);
+        }
 
+        template <typename Grid>
+        bool rotate_180(const Grid &grid, sf::Vector2u &pos) {
+            Rotation new_rot = (Rotation) (((int) rot + 2) % NUM_ROTATIONS);
+            return rotate_to(grid, pos, new_rot);
+        }
     };
 
+    template <typename Grid>
+    bool Tetromino::rotate_to(const Grid &grid, sf::Vector2u &pos, Rotation new_rot) {
+        if (!state_table.rotates[(int)kind]) return false;
+        const unsigned int num_kicks = state_table.num_kicks[(int)kind][(int)rot][(int)new_rot];
+        const KickOffset *kicks = state_table.kicks[(int)kind][(int)rot][(int)new_rot];
+        Tetromino rotated = *this;
+        rotated.rot = new_rot;
+        for (unsigned int i = 0; i < num_kicks; i++) {
+            int x = (int)pos.x + kicks[i].x;
+            int y = (int)pos.y + kicks[i].y;
+            if (x < 0 || y < 0) continue;
+
+            sf::Vector2u new_pos(x, y);
+            if (grid.can_place(new_pos, rotated)) {
+                rot = new_rot;
+                pos = new_pos;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <typename Derived>
+    template <typename Tile>
+    bool GridBase<Derived>::can_place(sf::Vector2u pos, const Tile &tile) const {
+        sf::Vector2u tile_size = tile.size();
+        sf::Vector2u this_size = self().size();
+        if (pos.x + tile_size.x > this_size.x) return false;
+        if (pos.y + tile_size.y > this_size.y) return false;
+        for (std::size_t y = 0; y < tile_size.y; y++) {
+            for (std::size_t x = 0; x < tile_size.x; x++) {
+                sf::Vector2u tilepos(x, y);
+                if (tile[tilepos] != Cell::N && self()[pos + tilepos] != Cell::N)
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    template <typename Derived>
+    bool GridBase<Derived>::can_place(sf::Vector2u pos, const Tetromino &piece) const {
+        const TetrominoState &state = piece.state();
+        sf::Vector2u this_size = self().size();
+        if (pos.x + state.width > this_size.x) return false;
+        if (pos.y + state.height > this_size.y) return false;
+        if (piece.type() == Cell::N) return true;
+        for (const TilePoint &p : state.cells) {
+            if (self()[pos + sf::Vector2u(p.x, p.y)] != Cell::N)
+                return false;
+        }
+
+        return true;
+    }
+
+    template <typename Derived>
+    template <typename Tile>
+    void GridBase<Derived>::place(sf::Vector2u pos, const Tile &tile) {
+        sf::Vector2u tile_size = tile.size();
+        for (std::size_t y = 0; y < tile_size.y; y++) {
+            for (std::size_t x = 0; x < tile_size.x; x++) {
+                sf::Vector2u tilepos(x, y);
+                Cell cell = tile[tilepos];
+                if (cell != Cell::N)
+                    self()[pos + tilepos] = cell;
+            }
+        }
+    }
+
+    template <typename Derived>
+    void GridBase<Derived>::place(sf::Vector2u pos, const Tetromino &piece) {
+        if (piece.type() == Cell::N) return;
+        for (const TilePoint &p : piece.state().cells)
+            self()[pos + sf::Vector2u(p.x, p.y)] = piece.type();
+    }
+
+    // uzskaitījums Randomizer nosaka, kā TetrominoProvider izvēlas gabalus
+    enum class Randomizer {
+        // each run of 7 pieces is a shuffled set of all of them
+        BAG_7,
+        // each run of 14 pieces is a shuffled set of two of each
+        BAG_14,
+        // every piece is drawn independently
+        MEMORYLESS,
+        // a draw that matches one of the last 4 pieces is redrawn up to 4 times, as in the first TGM
+        TGM_HISTORY,
+        // the 7-bag shuffled with std::mt19937 that games recorded before the other randomizers used
+        LEGACY_BAG_7,
+    };
+    constexpr int NUM_RANDOMIZERS = static_cast<int>(Randomizer::LEGACY_BAG_7) + 1;
+
+    // funkcija randomizer_name(randomizer) atgriež nosaukumu, ar ko randomizer izvēlas komandrindā
+    const char* randomizer_name(Randomizer randomizer);
+    // funkcija parse_randomizer(name, randomizer) ieraksta randomizer veidu ar nosaukumu name un atgriež false,
+    // ja tāda nav
+    bool parse_randomizer(const std::string &name, Randomizer &randomizer);
+
+    // Klase TetrominoProvider izdala gabalus pēc Randomizer veida ar Pcg32 ģeneratoru, kura plūsmu nosaka sēkla,
+    // tāpēc dažādām sēklām secības ir neatkarīgas. Viss stāvoklis ir daži desmiti baitu, un to var nolasīt un
+    // atjaunot ar get_state() un set_state().
     class TetrominoProvider {
+    public:
+        constexpr static std::size_t max_pool = 2 * NUM_TETROMINOES;
+        constexpr static std::size_t history_size = 4;
+        constexpr static unsigned int history_rolls = 4;
+
+        // struktūra State ir viss TetrominoProvider stāvoklis pēc randomizer izvēles
+        struct State {
+            // for LEGACY_BAG_7 these are the seed and the number of std::mt19937 outputs used so far
+            std::uint64_t rng_state;
+            std::uint64_t rng_increment;
+            // the bag, dealt from next up to size, or for TGM_HISTORY the last pieces with the newest first
+            array<Cell, max_pool> pool;
+            std::uint8_t size;
+            std::uint8_t next;
+
+            bool operator==(const State &other) const {
+                return rng_state == other.rng_state && rng_increment == other.rng_increment && pool == other.pool
+                    && size == other.size && next == other.next;
+            }
+            bool operator!=(const State &other) const { return !(*this == other); }
+        };
+
     private:
-        array<Tetromino, NUM_TETROMINOES> tetromino_bag;
-        std::size_t i;
-        std::mt19937 rng;
+        Randomizer randomizer;
+        Pcg32 rng;
+        std::uint32_t legacy_seed;
+        std::uint64_t legacy_draws;
+        // the std::mt19937 of LEGACY_BAG_7 and how many outputs it has given, built on first use; it is not
+        // part of State, which only needs legacy_draws to rebuild it
+        struct LegacyGenerator;
+        std::shared_ptr<LegacyGenerator> legacy_rng;
+        array<Cell, max_pool> pool;
+        std::uint8_t size;
+        std::uint8_t i;
+
         void reshuffle();
+        void legacy_reshuffle();
+        Cell draw_history();
     public:
         TetrominoProvider();
+        explicit TetrominoProvider(std::uint32_t seed, Randomizer randomizer = Randomizer::BAG_7);
         Tetromino next();
+        // metode bag_mask() atgriež to gabalu veidu masku (bits i atbilst Cell i), kas vēl palikuši pašreizējā
+        // maisā; 0 nozīmē, ka nākamais gabals nāks no jauna maisa. Veidiem bez maisa der jebkurš gabals.
+        std::uint8_t bag_mask() const;
+
+        Randomizer get_randomizer() const { return randomizer; }
+        // metode get_state() atgriež stāvokli, no kura set_state() turpina tieši to pašu secību
+        State get_state() const;
+        // metode set_state(state) atjauno stāvokli state, kas iegūts no TetrominoProvider ar to pašu randomizer
+        void set_state(const State &state);
     };
 
 
     extern const array<Tetromino, NUM_TETROMINOES> tetrominoes;
-    extern const sf::Color outline_color;
-    extern const array<sf::Color, NUM_CELLS> cell_colors;
 }
 
 #endif // GAME_H_
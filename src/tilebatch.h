@@ -0,0 +1,41 @@
+#ifndef TILEBATCH_H_
+#define TILEBATCH_H_
+
+#include <cstddef>
+#include <vector>
+#include <SFML/Graphics.hpp>
+
+namespace tetriskl {
+    // klase TileBatch glabā daudzus taisnstūrus ar kontūru vienā sf::VertexArray, lai tos visus varētu
+    // uzzīmēt ar vienu izsaukumu. Virsotnes tiek pārrēķinātas tikai tiem taisnstūriem, kas ir mainījušies.
+    class TileBatch: public sf::Drawable {
+    private:
+        struct Tile {
+            sf::Vector2f pos;
+            sf::Vector2f size;
+            sf::Color fill;
+            bool visible;
+        };
+
+        sf::VertexArray vertices;
+        std::vector<Tile> tiles;
+
+        constexpr static std::size_t vertices_per_tile = 5 * 4; // fill + 4 outline strips
+        constexpr static float outline_thickness = 0.03f;
+
+        void set_quad(std::size_t vertex, sf::Vector2f top_left, sf::Vector2f bottom_right, sf::Color color);
+    public:
+        TileBatch();
+
+        // metode resize(num_tiles) maina taisnstūru skaitu; jaunie taisnstūri ir neredzami
+        void resize(std::size_t num_tiles);
+        // metode set_tile(i, pos, size, fill) uzstāda i-tā taisnstūra novietojumu, izmēru un krāsu
+        void set_tile(std::size_t i, sf::Vector2f pos, sf::Vector2f size, sf::Color fill);
+        // metode hide_tile(i) padara i-to taisnstūri neredzamu
+        void hide_tile(std::size_t i);
+
+        void draw(sf::RenderTarget &target, sf::RenderStates states) const override;
+    };
+}
+
+#endif // TILEBATCH_H_
@@ -0,0 +1,89 @@
+#include "transtable.h"
+
+#include <cstring>
+#include <new>
+
+namespace tetriskl {
+    // the data word: bits 0-31 the score, 32-39 the depth, 40-47 the age, 48-62 the move and 63 set for every
+    // stored entry, so an empty slot (all zeros) never matches
+    constexpr std::uint64_t valid_bit = std::uint64_t(1) << 63;
+
+    std::uint64_t TranspositionTable::pack(const TableEntry &entry, std::uint8_t age) {
+        std::uint32_t score_bits;
+        std::memcpy(&score_bits, &entry.score, sizeof(score_bits));
+        return score_bits
+            | std::uint64_t(entry.depth) << 32
+            | std::uint64_t(age) << 40
+            | std::uint64_t(entry.move & max_move) << 48
+            | valid_bit;
+    }
+
+    TableEntry TranspositionTable::unpack(std::uint64_t data) {
+        TableEntry entry;
+        std::uint32_t score_bits = static_cast<std::uint32_t>(data);
+        std::memcpy(&entry.score, &score_bits, sizeof(score_bits));
+        entry.depth = static_cast<std::uint8_t>(data >> 32);
+        entry.move = static_cast<std::uint16_t>((data >> 48) & max_move);
+        return entry;
+    }
+
+    TranspositionTable::TranspositionTable(std::size_t megabytes) : storage(), buckets(), bucket_mask(), age(0) {
+        std::size_t num_buckets = 1;
+        while (num_buckets * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024) num_buckets *= 2;
+
+        storage.reset(new unsigned char[num_buckets * sizeof(Bucket) + cache_line]);
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(storage.get());
+        buckets = reinterpret_cast<Bucket*>((address + cache_line - 1) & ~std::uintptr_t(cache_line - 1));
+        bucket_mask = num_buckets - 1;
+        for (std::size_t i = 0; i < num_buckets; i++)
+            new (&buckets[i]) Bucket();
+        clear();
+    }
+
+    bool TranspositionTable::probe(std::uint64_t key, TableEntry &entry) const {
+        const Bucket &b = bucket(key);
+        for (const Slot &slot : b.slots) {
+            // the two words are written separately, so a torn entry fails this check instead of being returned
+            std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+            if ((data & valid_bit) && (slot.check.load(std::memory_order_relaxed) ^ data) == key) {
+                entry = unpack(data);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void TranspositionTable::store(std::uint64_t key, const TableEntry &entry) {
+        const std::uint8_t current_age = age.load(std::memory_order_relaxed);
+        Bucket &b = bucket(key);
+        Slot *victim = nullptr;
+        int victim_priority = 0;
+        for (Slot &slot : b.slots) {
+            std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+            if (!(data & valid_bit) || (slot.check.load(std::memory_order_relaxed) ^ data) == key) {
+                victim = &slot;
+                break;
+            }
+            // entries from older searches go first, then the shallowest ones
+            bool stale = static_cast<std::uint8_t>(data >> 40) != current_age;
+            int priority = (stale ? 256 : 0) + 255 - static_cast<std::uint8_t>(data >> 32);
+            if (victim == nullptr || priority > victim_priority) {
+                victim = &slot;
+                victim_priority = priority;
+            }
+        }
+
+        std::uint64_t data = pack(entry, current_age);
+        victim->check.store(key ^ data, std::memory_order_relaxed);
+        victim->data.store(data, std::memory_order_relaxed);
+    }
+
+    void TranspositionTable::clear() {
+        for (std::size_t i = 0; i <= bucket_mask; i++) {
+            for (Slot &slot : buckets[i].slots) {
+                slot.check.store(0, std::memory_order_relaxed);
+                slot.data.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef TRANSTABLE_H_
+#define TRANSTABLE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace tetriskl {
+    // struktūra TableEntry satur transpozīciju tabulā saglabāto pozīcijas vērtējumu
+    struct TableEntry {
+        float score;
+        // cik gabalus uz priekšu vērtējums ir meklēts
+        std::uint8_t depth;
+        // labākā gājiena numurs, ko izvēlas lietotājs
+        std::uint16_t move;
+    };
+
+    // Klase TranspositionTable ir fiksēta izmēra jaucējtabula, kurā meklēšana saglabā jau novērtētas pozīcijas,
+    // lai tās nebūtu jāvērtē atkārtoti. Tabulu var vienlaikus lietot vairāki pavedieni bez slēdzenēm: katrs
+    // ieraksts ir divi atomāri vārdi, no kuriem pirmais glabā atslēgu XOR datus, tāpēc sajaukts ieraksts, ko
+    // vienlaikus raksta divi pavedieni, vienkārši netiek atrasts. Katrs spainis aizņem vienu kešatmiņas rindu.
+    class TranspositionTable {
+    public:
+        constexpr static std::size_t cache_line = 64;
+        constexpr static std::size_t bucket_entries = 4;
+        constexpr static std::uint16_t max_move = 0x7fff;
+    private:
+        struct Slot {
+            std::atomic<std::uint64_t> check;
+            std::atomic<std::uint64_t> data;
+        };
+
+        struct alignas(cache_line) Bucket {
+            Slot slots[bucket_entries];
+        };
+        static_assert(sizeof(Bucket) == cache_line, "a bucket must fill exactly one cache line");
+
+        // operator new only honours alignas beyond alignof(std::max_align_t) since C++17, so the buckets are
+        // aligned by hand inside a slightly larger allocation
+        std::unique_ptr<unsigned char[]> storage;
+        Bucket *buckets;
+        std::size_t bucket_mask;
+        std::atomic<std::uint8_t> age;
+
+        Bucket& bucket(std::uint64_t key) const { return buckets[key & bucket_mask]; }
+
+        static std::uint64_t pack(const TableEntry &entry, std::uint8_t age);
+        static TableEntry unpack(std::uint64_t data);
+    public:
+        // konstruktors TranspositionTable(megabytes) izveido tabulu, kas aizņem ne vairāk kā megabytes MiB,
+        // un vismaz vienu spaini
+        explicit TranspositionTable(std::size_t megabytes = 16);
+
+        TranspositionTable(const TranspositionTable&) = delete;
+        TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+        // metode size() atgriež ierakstu skaitu tabulā
+        std::size_t size() const { return (bucket_mask + 1) * bucket_entries; }
+
+        // metode probe(key, entry) meklē pozīciju ar atslēgu key un, ja atrod, ieraksta tās datus entry
+        bool probe(std::uint64_t key, TableEntry &entry) const;
+
+        // metode store(key, entry) saglabā pozīcijas key datus. Ja spainī tās vēl nav, tiek aizstāts ieraksts no
+        // vecākas meklēšanas vai, ja tādu nav, ieraksts ar mazāko dziļumu.
+        void store(std::uint64_t key, const TableEntry &entry);
+
+        // metode new_search() atzīmē visus esošos ierakstus kā vecus, lai jaunā meklēšana tos aizstātu pirmos
+        void new_search() { age.fetch_add(1, std::memory_order_relaxed); }
+
+        // metode clear() izdzēš visus ierakstus; to nedrīkst izsaukt, kamēr tabulu lieto citi pavedieni
+        void clear();
+    };
+}
+
+#endif // TRANSTABLE_H_
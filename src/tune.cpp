@@ -0,0 +1,217 @@
+#include "autoplay.h"
+#include "bot.h"
+#include "workpool.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+// tetriskl-tune checkpoint [generations] [population] [games] [max-pieces] [threads]
+//
+// Tunes the bot's weights with the noisy cross-entropy method. Every generation samples population weight
+// vectors from a normal distribution, lets each of them play the same games (the seeds only depend on the
+// generation, so luck with the pieces affects all of them alike), and refits the distribution to the best
+// tenth. After every generation the distribution is saved to the file checkpoint, and if that file already
+// exists the tuner continues from it instead of starting over.
+
+namespace {
+    using tetriskl::BotWeights;
+
+    constexpr std::size_t num_weights = 7;
+    using WeightVector = std::array<double, num_weights>;
+
+    float BotWeights::* const weight_fields[num_weights] = {
+        &BotWeights::aggregate_height,
+        &BotWeights::holes,
+        &BotWeights::bumpiness,
+        &BotWeights::wells,
+        &BotWeights::row_transitions,
+        &BotWeights::column_transitions,
+        &BotWeights::lines_cleared,
+    };
+
+    const char *const weight_names[num_weights] = {
+        "aggregate_height",
+        "holes",
+        "bumpiness",
+        "wells",
+        "row_transitions",
+        "column_transitions",
+        "lines_cleared",
+    };
+
+    struct TunerState {
+        unsigned int generation;
+        WeightVector mean;
+        WeightVector stddev;
+        double best_fitness;
+        WeightVector best;
+    };
+
+    BotWeights to_bot_weights(const WeightVector &vector) {
+        BotWeights weights{};
+        for (std::size_t i = 0; i < num_weights; i++)
+            weights.*weight_fields[i] = static_cast<float>(vector[i]);
+        return weights;
+    }
+
+    TunerState initial_state() {
+        TunerState state{};
+        for (std::size_t i = 0; i < num_weights; i++) {
+            state.mean[i] = tetriskl::default_bot_weights.*weight_fields[i];
+            state.stddev[i] = std::max(std::abs(state.mean[i]), 1.0);
+        }
+        state.best_fitness = -1.0;
+        state.best = state.mean;
+        return state;
+    }
+
+    void write_vector(std::ostream &output, const char *name, const WeightVector &vector) {
+        output << name;
+        for (double value : vector)
+            output << " " << value;
+        output << "\n";
+    }
+
+    bool read_vector(std::istream &input, const char *name, WeightVector &vector) {
+        std::string key;
+        if (!(input >> key) || key != name) return false;
+        for (double &value : vector)
+            if (!(input >> value)) return false;
+        return true;
+    }
+
+    bool load_state(std::istream &input, TunerState &state) {
+        // read into a copy, so a checkpoint that turns out to be broken leaves nothing behind
+        TunerState loaded{};
+        std::string key;
+        bool read = input >> key && key == "generation" && input >> loaded.generation
+            && read_vector(input, "mean", loaded.mean)
+            && read_vector(input, "stddev", loaded.stddev)
+            && input >> key && key == "best_fitness" && input >> loaded.best_fitness
+            && read_vector(input, "best", loaded.best)
+            && (input >> std::ws).eof();
+        if (read) state = loaded;
+        return read;
+    }
+
+    bool save_state(const std::string &path, const TunerState &state) {
+        // written next to the checkpoint first, so an interruption never leaves half of one behind
+        std::string temporary_path = path + ".tmp";
+        std::ofstream output(temporary_path);
+        // every digit is kept, so a resumed run samples from exactly the same distribution
+        output.precision(std::numeric_limits<double>::max_digits10);
+        output << "generation " << state.generation << "\n";
+        write_vector(output, "mean", state.mean);
+        write_vector(output, "stddev", state.stddev);
+        output << "best_fitness " << state.best_fitness << "\n";
+        write_vector(output, "best", state.best);
+        output.close();
+        return output && std::rename(temporary_path.c_str(), path.c_str()) == 0;
+    }
+}
+
+int main(int argc, const char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " checkpoint [generations] [population] [games] [max-pieces] [threads]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+    const std::string checkpoint_path = argv[1];
+    unsigned int num_generations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 50;
+    std::size_t population = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 50;
+    std::size_t num_games = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 10;
+    unsigned int max_pieces = argc > 5 ? std::strtoul(argv[5], nullptr, 10) : 500;
+    std::size_t num_threads = argc > 6 ? std::strtoul(argv[6], nullptr, 10) : 0;
+    const std::size_t num_elite = std::max<std::size_t>(population / 10, 1);
+    if (population == 0 || num_games == 0) {
+        std::cerr << "population and games must not be 0" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    TunerState state = initial_state();
+    std::ifstream checkpoint(checkpoint_path);
+    if (checkpoint) {
+        // a checkpoint that can't be read is not overwritten, as it may hold many hours of tuning
+        if (!load_state(checkpoint, state)) {
+            std::cerr << checkpoint_path << ": not a tuner checkpoint" << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::cout << "resuming from generation " << state.generation << std::endl;
+    }
+    checkpoint.close();
+
+    tetriskl::WorkStealingPool pool(num_threads);
+    std::vector<tetriskl::Bot> bots(pool.size());
+    for (; state.generation < num_generations; state.generation++) {
+        // everything random in a generation follows from its number, so a resumed run repeats it exactly
+        std::mt19937 rng(state.generation);
+        std::vector<WeightVector> candidates(population);
+        for (WeightVector &candidate : candidates)
+            for (std::size_t i = 0; i < num_weights; i++)
+                candidate[i] = std::normal_distribution<double>(state.mean[i], state.stddev[i])(rng);
+        std::vector<std::uint32_t> seeds(num_games);
+        for (std::uint32_t &seed : seeds)
+            seed = rng();
+
+        std::vector<double> fitness(population, 0.0);
+        std::vector<unsigned int> scores(population * num_games);
+        pool.run(population * num_games, [&] (std::size_t task, std::size_t worker) {
+            tetriskl::Bot &bot = bots[worker];
+            bot.set_weights(to_bot_weights(candidates[task / num_games]));
+            scores[task] = tetriskl::play_game(seeds[task % num_games], bot, max_pieces).score;
+        });
+        for (std::size_t task = 0; task < scores.size(); task++)
+            fitness[task / num_games] += static_cast<double>(scores[task]) / num_games;
+
+        std::vector<std::size_t> order(population);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&] (std::size_t a, std::size_t b) { return fitness[a] > fitness[b]; });
+        if (fitness[order[0]] > state.best_fitness) {
+            state.best_fitness = fitness[order[0]];
+            state.best = candidates[order[0]];
+        }
+
+        // refit to the elite, with extra noise that fades out so the search doesn't collapse too early
+        const double noise = std::max(5.0 - state.generation / 10.0, 0.0);
+        double elite_fitness = 0.0;
+        for (std::size_t i = 0; i < num_weights; i++) {
+            double mean = 0.0;
+            for (std::size_t e = 0; e < num_elite; e++)
+                mean += candidates[order[e]][i] / num_elite;
+            double variance = 0.0;
+            for (std::size_t e = 0; e < num_elite; e++)
+                variance += (candidates[order[e]][i] - mean) * (candidates[order[e]][i] - mean) / num_elite;
+            state.mean[i] = mean;
+            // the normal distribution needs a positive spread even once the elite agrees completely
+            state.stddev[i] = std::max(std::sqrt(variance + noise), 1e-3);
+        }
+        for (std::size_t e = 0; e < num_elite; e++)
+            elite_fitness += fitness[order[e]] / num_elite;
+
+        std::cout << "generation " << state.generation << ": best " << fitness[order[0]]
+                  << ", elite mean " << elite_fitness << std::endl;
+
+        TunerState saved = state;
+        saved.generation++;
+        if (!save_state(checkpoint_path, saved)) {
+            std::cerr << "cannot write " << checkpoint_path << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::cout << "best fitness " << state.best_fitness << std::endl;
+    for (std::size_t i = 0; i < num_weights; i++)
+        std::cout << weight_names[i] << " " << state.best[i] << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,77 @@
+#include "workpool.h"
+
+#include <exception>
+#include <thread>
+
+namespace tetriskl {
+    static std::size_t default_num_threads() {
+        std::size_t hardware_threads = std::thread::hardware_concurrency();
+        return hardware_threads != 0 ? hardware_threads : 1;
+    }
+
+    WorkStealingPool::WorkStealingPool(std::size_t num_threads)
+        : num_threads(num_threads != 0 ? num_threads : default_num_threads()),
+          queues(this->num_threads) {}
+
+    bool WorkStealingPool::pop(std::size_t worker, std::size_t &task) {
+        TaskQueue &queue = queues[worker];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (queue.tasks.empty()) return false;
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    bool WorkStealingPool::steal(std::size_t worker, std::size_t &task) {
+        // the front of a queue holds the tasks its owner would reach last
+        for (std::size_t i = 1; i < num_threads; i++) {
+            TaskQueue &victim = queues[(worker + i) % num_threads];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (victim.tasks.empty()) continue;
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    void WorkStealingPool::work(std::size_t worker, const task_fn &fn) {
+        std::size_t task;
+        // tasks never add more tasks, so once every queue is empty the work is done
+        while (pop(worker, task) || steal(worker, task))
+            fn(task, worker);
+    }
+
+    void WorkStealingPool::run(std::size_t num_tasks, const task_fn &fn) {
+        // every worker starts with a contiguous share, which it works through from the front while thieves
+        // take from the back
+        for (std::size_t worker = 0; worker < num_threads; worker++) {
+            std::deque<std::size_t> &tasks = queues[worker].tasks;
+            tasks.clear();
+            for (std::size_t task = num_tasks * worker / num_threads; task < num_tasks * (worker + 1) / num_threads; task++)
+                tasks.push_front(task);
+        }
+
+        std::vector<std::thread> threads;
+        std::vector<std::exception_ptr> errors(num_threads);
+        for (std::size_t worker = 1; worker < num_threads; worker++) {
+            threads.emplace_back([this, worker, &fn, &errors] () {
+                try {
+                    work(worker, fn);
+                } catch (...) {
+                    errors[worker] = std::current_exception();
+                }
+            });
+        }
+        try {
+            work(0, fn);
+        } catch (...) {
+            errors[0] = std::current_exception();
+        }
+        for (std::thread &thread : threads)
+            thread.join();
+
+        for (const std::exception_ptr &error : errors)
+            if (error) std::rethrow_exception(error);
+    }
+}
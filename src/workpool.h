@@ -0,0 +1,47 @@
+#ifndef WORKPOOL_H_
+#define WORKPOOL_H_
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace tetriskl {
+    // Klase WorkStealingPool izpilda neatkarīgus uzdevumus vairākos pavedienos. Katram pavedienam ir sava
+    // uzdevumu rinda, ko tas apstrādā no beigām, bet, kad tā ir tukša, tas zog uzdevumus no citu rindu sākuma,
+    // tāpēc nevienmērīgi lieli uzdevumi tik un tā tiek sadalīti vienmērīgi.
+    class WorkStealingPool {
+    public:
+        using task_fn = std::function<void(std::size_t task, std::size_t worker)>;
+    private:
+        constexpr static std::size_t cache_line = 64;
+
+        // std::allocator only honours alignas beyond alignof(std::max_align_t) since C++17, so instead of aligning
+        // the queues, a cache line of padding after each one keeps neighbouring queues off each other's lines
+        struct TaskQueue {
+            std::mutex lock;
+            std::deque<std::size_t> tasks;
+            unsigned char padding[cache_line];
+        };
+
+        std::size_t num_threads;
+        std::vector<TaskQueue> queues;
+
+        bool pop(std::size_t worker, std::size_t &task);
+        bool steal(std::size_t worker, std::size_t &task);
+        void work(std::size_t worker, const task_fn &fn);
+    public:
+        // konstruktors WorkStealingPool(num_threads) izveido pūlu ar num_threads pavedieniem;
+        // 0 nozīmē tik pavedienu, cik ir aparatūras pavedienu
+        explicit WorkStealingPool(std::size_t num_threads = 0);
+
+        std::size_t size() const { return num_threads; }
+
+        // metode run(num_tasks, fn) izsauc fn(task, worker) katram uzdevumam no 0 līdz num_tasks - 1 un atgriežas,
+        // kad visi ir izpildīti. Parametrs worker ir izpildītāja pavediena numurs, kas ir mazāks par size().
+        void run(std::size_t num_tasks, const task_fn &fn);
+    };
+}
+
+#endif // WORKPOOL_H_
@@ -0,0 +1,5 @@
+#include "zobrist.h"
+
+namespace tetriskl {
+    constexpr ZobristTable Zobrist::table;
+}
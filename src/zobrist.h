@@ -0,0 +1,71 @@
+#ifndef ZOBRIST_H_
+#define ZOBRIST_H_
+#include "bitops.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace tetriskl {
+    constexpr std::size_t ZOBRIST_ROWS = 32;
+    constexpr std::size_t ZOBRIST_COLUMNS = 32;
+    constexpr std::size_t ZOBRIST_PIECES = 8;
+
+    // struktūra ZobristTable satur nejaušu 64 bitu atslēgu katrai lauciņa šūnai un katram gabala veidam
+    struct ZobristTable {
+        std::uint64_t cells[ZOBRIST_ROWS][ZOBRIST_COLUMNS];
+        std::uint64_t pieces[ZOBRIST_PIECES];
+    };
+
+    // funkcija splitmix64(state) pavirza stāvokli state un atgriež nākamo pseidonejaušo skaitli
+    constexpr std::uint64_t splitmix64(std::uint64_t &state) {
+        state += 0x9e3779b97f4a7c15u;
+        std::uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9u;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebu;
+        return z ^ (z >> 31);
+    }
+
+    constexpr ZobristTable make_zobrist_table() {
+        ZobristTable table{};
+        std::uint64_t state = 0;
+        for (std::size_t y = 0; y < ZOBRIST_ROWS; y++)
+            for (std::size_t x = 0; x < ZOBRIST_COLUMNS; x++)
+                table.cells[y][x] = splitmix64(state);
+        for (std::size_t i = 0; i < ZOBRIST_PIECES; i++)
+            table.pieces[i] = splitmix64(state);
+        return table;
+    }
+
+    // Klase Zobrist aprēķina lauciņa aizņemtības jaucējvērtību kā aizņemto šūnu atslēgu XOR. Tā kā katra šūna
+    // ienāk tajā neatkarīgi, lauciņa jaucējvērtību var atjaunot pa daļām, kad šūnas tiek aizpildītas vai pārvietotas.
+    class Zobrist {
+    public:
+        static constexpr ZobristTable table = make_zobrist_table();
+
+        // metode row_key(y, mask) atgriež rindas y šūnu, kas iestatītas maskā mask, atslēgu XOR
+        static std::uint64_t row_key(std::size_t y, std::uint32_t mask) {
+            std::uint64_t key = 0;
+            for (; mask != 0; mask &= mask - 1)
+                key ^= table.cells[y][lowest_bit(mask)];
+            return key;
+        }
+
+        // metode piece_key(kind) atgriež gabala veida kind atslēgu, ar ko pozīcijas atslēgā var iekļaut nākamo gabalu
+        static std::uint64_t piece_key(std::size_t kind) {
+            return table.pieces[kind];
+        }
+
+        // metode board_key(rows) aprēķina visa lauciņa jaucējvērtību no tā rindu maskām
+        template <std::size_t Rows>
+        static std::uint64_t board_key(const std::array<std::uint32_t, Rows> &rows) {
+            static_assert(Rows <= ZOBRIST_ROWS, "board has more rows than the Zobrist table");
+            std::uint64_t key = 0;
+            for (std::size_t y = 0; y < Rows; y++)
+                key ^= row_key(y, rows[y]);
+            return key;
+        }
+    };
+}
+
+#endif // ZOBRIST_H_